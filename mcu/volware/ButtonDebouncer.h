@@ -0,0 +1,73 @@
+/**
+ * VolWare button debouncing
+ *
+ * Plain C++ like VolwareProtocol.h, so the state machine can be exercised
+ * on the PC with made-up input and timestamps.
+ *
+ * The debouncer reacts to the first edge of a press or release and then
+ * ignores the contact for debounceMs, so a press is seen within one poll
+ * instead of after the bouncing has died down, and the bounce itself can no
+ * longer toggle the state twice. A button held for longPressMs additionally
+ * reports a long press, once per press.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace volware {
+
+enum ButtonEvent : uint8_t {
+    BUTTON_NONE,
+    BUTTON_PRESSED,
+    BUTTON_RELEASED,
+    BUTTON_LONG_PRESS
+};
+
+struct ButtonTiming {
+    uint16_t debounceMs;  // Contact changes ignored after an edge
+    uint16_t longPressMs; // Hold time of a long press, 0 to disable
+};
+
+class ButtonDebouncer {
+public:
+    ButtonDebouncer() : m_pressed(false), m_longPressSent(false), m_edgeMs(0) {}
+
+    /**
+     * Feeds the current contact state, sampled at nowMs (millis()), and
+     * returns what happened. Poll at least once per debounceMs.
+     */
+    ButtonEvent update(bool pressed, uint32_t nowMs,
+                       const ButtonTiming &timing) {
+        uint32_t sinceEdgeMs = nowMs - m_edgeMs;
+        if (sinceEdgeMs < timing.debounceMs) {
+            return BUTTON_NONE;
+        }
+
+        if (pressed != m_pressed) {
+            m_pressed = pressed;
+            m_edgeMs = nowMs;
+            m_longPressSent = false;
+            return pressed ? BUTTON_PRESSED : BUTTON_RELEASED;
+        }
+
+        if (m_pressed && !m_longPressSent && timing.longPressMs > 0 &&
+            sinceEdgeMs >= timing.longPressMs) {
+            m_longPressSent = true;
+            return BUTTON_LONG_PRESS;
+        }
+        return BUTTON_NONE;
+    }
+
+    /**
+     * Debounced contact state
+     */
+    bool pressed() const { return m_pressed; }
+
+private:
+    bool m_pressed;
+    bool m_longPressSent;
+    uint32_t m_edgeMs; // When m_pressed last changed
+};
+
+} // namespace volware
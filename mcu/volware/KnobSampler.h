@@ -0,0 +1,175 @@
+/**
+ * VolWare knob sampling
+ *
+ * The firmware's ADC scheduling and averaging, kept in plain C++ like
+ * VolwareProtocol.h so the PC tools can run the exact same code on
+ * recorded or synthetic readings.
+ *
+ * SAMPLING:
+ * The sketch reads one ADC value per sample interval instead of sleeping
+ * between reads. The channels are read one after another in bursts: the
+ * first reading after switching the ADC multiplexer is discarded, since the
+ * sample-and-hold capacitor may not have settled from the previous pin yet,
+ * and the next 2^oversampleShift readings are averaged. An averaged value
+ * that differs from the last reported one by at least the noise threshold
+ * marks its channel as changed. A parked channel, one the PC has taken
+ * over, needs a move of protocol::PICKUP_THRESHOLD instead.
+ *
+ * Frames are sent on their own, slower interval with whatever changed in
+ * between, so the sampling rate and the frame rate can be tuned separately.
+ */
+
+#pragma once
+
+#include "VolwareProtocol.h"
+
+#include <stdint.h>
+
+namespace volware {
+
+/**
+ * Periodic timer for millis() or micros() timestamps, safe across their
+ * wrap-around. A call that comes late does not make the next period
+ * shorter, and after a stall of more than a period it restarts from now
+ * instead of firing repeatedly to catch up.
+ */
+class Interval {
+public:
+    explicit Interval(uint32_t period) : m_period(period), m_last(0) {}
+
+    bool due(uint32_t now) {
+        if ((uint32_t)(now - m_last) < m_period) {
+            return false;
+        }
+        m_last += m_period;
+        if ((uint32_t)(now - m_last) >= m_period) {
+            m_last = now;
+        }
+        return true;
+    }
+
+private:
+    uint32_t m_period;
+    uint32_t m_last;
+};
+
+/**
+ * Oversampling and change detection for up to protocol::MAX_CHANNELS
+ * potentiometers
+ */
+class KnobSampler {
+public:
+    // oversampleShift of 3 averages 8 readings; at most 6 so the sum of
+    // 10-bit readings fits 16 bits
+    KnobSampler(uint8_t channels, uint8_t oversampleShift,
+                int noiseThreshold)
+        : m_channels(channels > protocol::MAX_CHANNELS
+                         ? protocol::MAX_CHANNELS
+                         : channels),
+          m_shift(oversampleShift > 6 ? 6 : oversampleShift),
+          m_threshold(noiseThreshold), m_channel(0), m_count(0), m_sum(0),
+          m_sampled(0), m_changed(0), m_parked(0) {
+        for (uint8_t i = 0; i < protocol::MAX_CHANNELS; i++) {
+            m_values[i] = 0;
+        }
+        m_discard = m_channels > 1;
+    }
+
+    /**
+     * Channel the next reading must be taken from
+     */
+    uint8_t channel() const { return m_channel; }
+
+    /**
+     * Adds a raw ADC reading of channel(). Returns true when it completed
+     * an averaged value, after which channel() may have moved on.
+     */
+    bool addReading(int reading) {
+        if (m_discard) {
+            m_discard = false;
+            return false;
+        }
+
+        reading = reading < 0 ? 0
+                  : (reading > protocol::VALUE_MAX ? protocol::VALUE_MAX
+                                                   : reading);
+        m_sum += (uint16_t)reading;
+        if (++m_count < (1u << m_shift)) {
+            return false;
+        }
+
+        // Round to nearest instead of truncating the average
+        int value = (int)((m_sum + ((1u << m_shift) >> 1)) >> m_shift);
+        uint8_t bit = 1u << m_channel;
+        int difference = value - m_values[m_channel];
+        int threshold =
+            (m_parked & bit) ? protocol::PICKUP_THRESHOLD : m_threshold;
+        if (!(m_sampled & bit) || difference >= threshold ||
+            -difference >= threshold) {
+            m_values[m_channel] = value;
+            m_changed |= bit;
+            m_parked &= (uint8_t)~bit;
+        }
+        m_sampled |= bit;
+
+        m_sum = 0;
+        m_count = 0;
+        if (m_channels > 1) {
+            m_channel = (uint8_t)((m_channel + 1) % m_channels);
+            m_discard = true;
+        }
+        return true;
+    }
+
+    /**
+     * Mask of the channels that changed since the last call
+     */
+    uint8_t takeChanged() {
+        uint8_t changed = m_changed;
+        m_changed = 0;
+        return changed;
+    }
+
+    /**
+     * Last reported value of every channel, indexed by channel
+     */
+    const int *values() const { return m_values; }
+
+    /**
+     * Tells the sampler the PC's position for a channel. If the knob is not
+     * there, the channel is parked: small moves are no longer reported, so
+     * noise cannot undo a change made on the PC, until the knob is turned
+     * by PICKUP_THRESHOLD.
+     */
+    void setHostValue(uint8_t channel, int hostValue) {
+        if (channel >= m_channels) {
+            return;
+        }
+        uint8_t bit = 1u << channel;
+        int difference = hostValue - m_values[channel];
+        if (difference >= protocol::PICKUP_THRESHOLD ||
+            -difference >= protocol::PICKUP_THRESHOLD) {
+            m_parked |= bit;
+        } else {
+            m_parked &= (uint8_t)~bit;
+        }
+    }
+
+private:
+    uint8_t m_channels;
+    uint8_t m_shift;
+    int m_threshold;
+
+    // Burst in progress
+    uint8_t m_channel;
+    uint8_t m_count;
+    uint16_t m_sum;
+    bool m_discard;
+
+    int m_values[protocol::MAX_CHANNELS];
+    uint8_t m_sampled; // Channels with at least one averaged value
+    uint8_t m_changed;
+    uint8_t m_parked; // Channels taken over by the PC
+};
+
+} // namespace volware
@@ -0,0 +1,390 @@
+/**
+ * VolWare serial protocol
+ *
+ * Shared by the firmware and the PC application, so it only uses plain C++
+ * that builds with avr-gcc and with a desktop compiler.
+ *
+ * HANDSHAKE (PC -> device, single characters):
+ * - 's' requests a full frame with the current state
+ * - 'b' switches the device to binary frames
+ * - 'a' switches the device back to ASCII frames
+ * Firmware that does not know a character ignores it, so the PC can always
+ * send "bs" and fall back to ASCII frames from older firmware.
+ *
+ * HOST STATE (PC -> device):
+ * M<MASK><MUTE><VALUE>...\n
+ * - sent when another program changed a volume or mute on the PC
+ * - MASK   2 hex digits, bit i set when channel i is carried
+ * - MUTE   2 hex digits, bit i holds the PC's mute state of channel i
+ * - VALUE  3 hex digits per channel in MASK, ascending: the knob position
+ *          (0-1023) that matches the channel's volume on the PC
+ * Only uppercase hex digits are used, so older firmware ignores the whole
+ * message. The device shows the mute states on its LEDs and stops
+ * reporting a knob whose position disagrees with the PC until it has been
+ * moved by PICKUP_THRESHOLD; the PC does the same with the values it
+ * receives, so whichever side changed last wins.
+ *
+ * ASCII FRAME (device -> PC):
+ * value1,value2,...,mute1,mute2,...\n
+ * - values 0-1023 in decimal without leading zeros, one per channel
+ * - mute states 0 or 1, only on devices with mute buttons
+ *
+ * BINARY FRAME (device -> PC):
+ * [SYNC][TYPE][SEQ][MASK][MUTE][TIME][VALUES...][CRC]
+ * - SYNC   0xA5, never part of an ASCII frame
+ * - TYPE   FRAME_FULL carries every channel and acts as a keyframe,
+ *          FRAME_DELTA carries only the channels that changed since the
+ *          previous frame; FRAME_FLAG_TIME may be or-ed into either
+ * - SEQ    sequence number, incremented for every frame sent
+ * - MASK   bit i set when channel i is carried in the frame
+ * - MUTE   bit i holds the mute state of channel i, always for all channels
+ * - TIME   only with FRAME_FLAG_TIME: the device's millis() when the frame
+ *          was sampled, 4 bytes little endian
+ * - VALUES 10-bit potentiometer values of the channels in MASK, in
+ *          ascending channel order, packed LSB first
+ * - CRC    CRC-8 (polynomial 0x07) over TYPE up to the last VALUES byte
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace volware {
+namespace protocol {
+
+const uint8_t SYNC_BYTE = 0xA5;
+
+// Frame types
+const uint8_t FRAME_FULL = 0x01;
+const uint8_t FRAME_DELTA = 0x02;
+const uint8_t FRAME_FLAG_TIME = 0x80;
+const uint8_t FRAME_TYPE_MASK = 0x7F;
+
+// Handshake characters
+const char REQUEST_SYNC = 's';
+const char REQUEST_BINARY = 'b';
+const char REQUEST_ASCII = 'a';
+const char HOST_STATE = 'M';
+
+// Limits
+const uint8_t MAX_CHANNELS = 8;
+const uint8_t VALUE_BITS = 10;
+const uint16_t VALUE_MAX = (1u << VALUE_BITS) - 1;
+const uint8_t HEADER_SIZE = 5; // SYNC, TYPE, SEQ, MASK, MUTE
+const uint8_t TIME_SIZE = 4;
+const uint8_t MAX_FRAME_SIZE =
+    HEADER_SIZE + TIME_SIZE + (MAX_CHANNELS * VALUE_BITS + 7) / 8 + 1;
+const uint8_t MAX_ASCII_FRAME_SIZE =
+    MAX_CHANNELS * 5 + MAX_CHANNELS * 2; // "1023," and "1," per channel
+const uint8_t MAX_HOST_STATE_SIZE = 1 + 2 + 2 + MAX_CHANNELS * 3 + 1;
+
+// Knob travel that counts as a deliberate move after the PC took over
+const int PICKUP_THRESHOLD = 8;
+
+/**
+ * Number of channels set in a channel mask
+ */
+inline uint8_t channelCount(uint8_t mask) {
+    uint8_t count = 0;
+    for (; mask; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Offset of the packed values in a frame of the given type
+ */
+inline uint8_t valuesOffset(uint8_t type) {
+    return HEADER_SIZE + ((type & FRAME_FLAG_TIME) ? TIME_SIZE : 0);
+}
+
+/**
+ * Total size of a binary frame of the given type carrying the channels in
+ * mask
+ */
+inline uint8_t frameSize(uint8_t type, uint8_t mask) {
+    return valuesOffset(type) + (channelCount(mask) * VALUE_BITS + 7) / 8 + 1;
+}
+
+/**
+ * CRC-8 with polynomial 0x07 and zero initial value
+ */
+inline uint8_t crc8(const uint8_t *data, uint8_t length) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07)
+                               : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * Encodes a binary frame into out, which must hold MAX_FRAME_SIZE bytes.
+ * values is indexed by channel; only channels set in mask are written.
+ * timeMs is only written when type has FRAME_FLAG_TIME set.
+ * Returns the number of bytes written.
+ */
+inline uint8_t encodeFrame(uint8_t *out, uint8_t type, uint8_t seq,
+                           uint8_t mask, uint8_t muteBits, const int *values,
+                           uint32_t timeMs = 0) {
+    out[0] = SYNC_BYTE;
+    out[1] = type;
+    out[2] = seq;
+    out[3] = mask;
+    out[4] = muteBits;
+
+    uint8_t length = HEADER_SIZE;
+    if (type & FRAME_FLAG_TIME) {
+        for (uint8_t i = 0; i < TIME_SIZE; i++) {
+            out[length++] = (uint8_t)(timeMs >> (8 * i));
+        }
+    }
+
+    uint32_t bitBuffer = 0;
+    uint8_t bitCount = 0;
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        if (!(mask & (1u << channel))) {
+            continue;
+        }
+        int value = values[channel];
+        value = value < 0 ? 0 : (value > VALUE_MAX ? VALUE_MAX : value);
+
+        // Append 10 bits and flush whole bytes
+        bitBuffer |= (uint32_t)value << bitCount;
+        bitCount += VALUE_BITS;
+        while (bitCount >= 8) {
+            out[length++] = (uint8_t)bitBuffer;
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+    if (bitCount > 0) {
+        out[length++] = (uint8_t)bitBuffer;
+    }
+
+    out[length] = crc8(out + 1, length - 1);
+    return length + 1;
+}
+
+/**
+ * Writes value, clamped to 0-VALUE_MAX, in decimal to out without a
+ * terminator. Subtracts powers of ten instead of dividing, which is much
+ * cheaper on an 8-bit AVR. Returns the number of characters written.
+ */
+inline uint8_t formatValue(char *out, int value) {
+    static const uint16_t POWERS[] = {1000, 100, 10};
+
+    uint16_t remainder =
+        value < 0 ? 0 : (value > VALUE_MAX ? VALUE_MAX : (uint16_t)value);
+    uint8_t length = 0;
+    for (uint8_t i = 0; i < sizeof(POWERS) / sizeof(POWERS[0]); i++) {
+        char digit = '0';
+        while (remainder >= POWERS[i]) {
+            remainder -= POWERS[i];
+            digit++;
+        }
+        if (digit != '0' || length > 0) {
+            out[length++] = digit;
+        }
+    }
+    out[length++] = (char)('0' + remainder);
+    return length;
+}
+
+/**
+ * Encodes an ASCII frame into out, which must hold MAX_ASCII_FRAME_SIZE
+ * bytes. values is indexed by channel; mute states are taken from bit i of
+ * muteBits for the first muteCount channels. The frame ends with '\n' and
+ * is not NUL-terminated. Returns the number of bytes written.
+ */
+inline uint8_t encodeAsciiFrame(char *out, const int *values,
+                                uint8_t channels, uint8_t muteBits,
+                                uint8_t muteCount) {
+    channels = channels > MAX_CHANNELS ? MAX_CHANNELS : channels;
+    muteCount = muteCount > MAX_CHANNELS ? MAX_CHANNELS : muteCount;
+
+    uint8_t length = 0;
+    for (uint8_t channel = 0; channel < channels; channel++) {
+        length += formatValue(out + length, values[channel]);
+        out[length++] = ',';
+    }
+    for (uint8_t channel = 0; channel < muteCount; channel++) {
+        out[length++] = (muteBits & (1u << channel)) ? '1' : '0';
+        out[length++] = ',';
+    }
+
+    // The last separator becomes the line end
+    if (length == 0) {
+        length++;
+    }
+    out[length - 1] = '\n';
+    return length;
+}
+
+/**
+ * Encodes a host state message into out, which must hold
+ * MAX_HOST_STATE_SIZE bytes. values is indexed by channel; only channels
+ * set in mask are written. Returns the number of bytes written.
+ */
+inline uint8_t encodeHostState(char *out, uint8_t mask, uint8_t muteBits,
+                               const int *values) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    uint8_t length = 0;
+    out[length++] = HOST_STATE;
+    out[length++] = HEX_DIGITS[mask >> 4];
+    out[length++] = HEX_DIGITS[mask & 0xF];
+    out[length++] = HEX_DIGITS[(muteBits & mask) >> 4];
+    out[length++] = HEX_DIGITS[(muteBits & mask) & 0xF];
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        if (!(mask & (1u << channel))) {
+            continue;
+        }
+        int value = values[channel];
+        value = value < 0 ? 0 : (value > VALUE_MAX ? VALUE_MAX : value);
+        out[length++] = HEX_DIGITS[(value >> 8) & 0xF];
+        out[length++] = HEX_DIGITS[(value >> 4) & 0xF];
+        out[length++] = HEX_DIGITS[value & 0xF];
+    }
+    out[length++] = '\n';
+    return length;
+}
+
+/**
+ * Incremental decoder for host state messages, fed one received character
+ * at a time so the firmware needs no line buffer
+ */
+class HostStateDecoder {
+public:
+    HostStateDecoder()
+        : m_active(false), m_ready(false), m_digits(0), m_mask(0),
+          m_muteBits(0), m_channel(0), m_value(0) {
+        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+            m_values[i] = 0;
+        }
+    }
+
+    /**
+     * Feeds one character. Returns false if it is not part of a host state
+     * message, in which case the caller handles it as a request; a message
+     * cut short by such a character is dropped. After a true return,
+     * ready() tells whether c completed a valid message.
+     */
+    bool feed(char c) {
+        m_ready = false;
+        if (!m_active) {
+            if (c != HOST_STATE) {
+                return false;
+            }
+            m_active = true;
+            m_digits = 0;
+            m_mask = 0;
+            m_muteBits = 0;
+            m_channel = 0;
+            m_value = 0;
+            return true;
+        }
+
+        if (c == '\n') {
+            m_active = false;
+            m_ready = m_digits >= 4 &&
+                      m_digits == 4 + 3 * channelCount(m_mask);
+            return true;
+        }
+
+        int8_t nibble = c >= '0' && c <= '9'   ? c - '0'
+                        : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                               : -1;
+        if (nibble < 0 || m_digits >= 4 + 3 * MAX_CHANNELS) {
+            m_active = false;
+            return false;
+        }
+
+        if (m_digits < 2) {
+            m_mask = (uint8_t)(m_mask << 4 | nibble);
+        } else if (m_digits < 4) {
+            m_muteBits = (uint8_t)(m_muteBits << 4 | nibble);
+        } else {
+            m_value = (uint16_t)(m_value << 4 | nibble);
+            if ((m_digits - 4) % 3 == 2) {
+                // Value complete, store it under the next channel in mask
+                while (m_channel < MAX_CHANNELS &&
+                       !(m_mask & (1u << m_channel))) {
+                    m_channel++;
+                }
+                if (m_channel < MAX_CHANNELS) {
+                    m_values[m_channel++] =
+                        m_value > VALUE_MAX ? VALUE_MAX : m_value;
+                }
+                m_value = 0;
+            }
+        }
+        m_digits++;
+        return true;
+    }
+
+    bool ready() const { return m_ready; }
+
+    // Contents of the message, valid when ready() is set
+    uint8_t mask() const { return m_mask; }
+    uint8_t muteBits() const { return m_muteBits; }
+    int value(uint8_t channel) const { return m_values[channel]; }
+
+private:
+    bool m_active; // Inside a message
+    bool m_ready;
+    uint8_t m_digits; // Hex digits received so far
+    uint8_t m_mask;
+    uint8_t m_muteBits;
+    uint8_t m_channel; // Next channel to look for in the mask
+    uint16_t m_value;  // Value being assembled
+    uint16_t m_values[MAX_CHANNELS];
+};
+
+/**
+ * Unpacks the values of a complete, CRC-checked frame into values, indexed
+ * by channel. Channels not set in the frame's mask are left untouched.
+ */
+inline void unpackValues(const uint8_t *frame, uint16_t *values) {
+    uint8_t mask = frame[3];
+    const uint8_t *packed = frame + valuesOffset(frame[1]);
+
+    uint16_t bitOffset = 0;
+    for (uint8_t channel = 0; channel < MAX_CHANNELS; channel++) {
+        if (!(mask & (1u << channel))) {
+            continue;
+        }
+        uint8_t byteIndex = bitOffset / 8;
+        uint8_t shift = bitOffset % 8;
+        uint16_t raw =
+            packed[byteIndex] | (uint16_t)packed[byteIndex + 1] << 8;
+        values[channel] = (raw >> shift) & VALUE_MAX;
+        bitOffset += VALUE_BITS;
+    }
+}
+
+/**
+ * Device time carried by a complete frame with FRAME_FLAG_TIME set
+ */
+inline uint32_t frameTime(const uint8_t *frame) {
+    uint32_t timeMs = 0;
+    for (uint8_t i = 0; i < TIME_SIZE; i++) {
+        timeMs |= (uint32_t)frame[HEADER_SIZE + i] << (8 * i);
+    }
+    return timeMs;
+}
+
+/**
+ * Checks the CRC of a complete frame of the given size
+ */
+inline bool checkFrame(const uint8_t *frame, uint8_t size) {
+    return frame[0] == SYNC_BYTE &&
+           crc8(frame + 1, size - 2) == frame[size - 1];
+}
+
+} // namespace protocol
+} // namespace volware
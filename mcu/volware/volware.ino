@@ -14,8 +14,25 @@
  * value1,value2,...,mute1,mute2,...\n
  * - where values are between 0-1023 representing potentiometer positions
  * - mute values are 0 or 1 indicating mute state (if applicable)
+ *
+ * When the PC requests it with 'b', compact binary frames are sent instead
+ * (see VolwareProtocol.h).
+ *
+ * The loop never sleeps: the potentiometers are oversampled on a fixed
+ * sample interval (see KnobSampler.h), and frames with the changes are sent
+ * on a separate, slower frame interval. Mute buttons are debounced (see
+ * ButtonDebouncer.h) and a mute change is sent right away. Holding a mute
+ * button mutes every other channel and unmutes its own.
+ *
+ * The PC reports volume and mute changes made on its side (the 'M' message
+ * in VolwareProtocol.h): the mute LEDs follow them, and knobs that no
+ * longer match are only reported again once they are turned.
  */
 
+#include "ButtonDebouncer.h"
+#include "KnobSampler.h"
+#include "VolwareProtocol.h"
+
 // =================== USER SPECIFIC SETTINGS ===================
 
 // Hardware configuration
@@ -30,12 +47,56 @@ const int numMuteButtons = 5;       // Number of mute buttons connected
 const int noiseThreshold =
     2; // Increase for less noise, decrease for more sensitivity
 
+// Sampling - one ADC reading per interval, 2^oversampleShift readings
+// averaged per value. With 5 knobs every knob gets a new value about every
+// 5 * (8 + 1) * 250 us = 11 ms.
+const unsigned long sampleIntervalUs = 250;
+const byte oversampleShift = 3;
+
+// Frames are sent at most this often, with everything that changed since
+// the previous one
+const unsigned long frameIntervalMs = 10;
+
+// Mute buttons are polled every millisecond; contact changes within
+// debounceMs of a press or release are bounce, and holding a button for
+// longPressMs solos its channel (0 disables)
+const unsigned long buttonIntervalMs = 1;
+const volware::ButtonTiming buttonTiming = {
+    20,  // debounceMs
+    800, // longPressMs
+};
+
+// Binary mode only sends changed channels; a full keyframe is still sent at
+// least this often so the PC can resync after a lost frame
+const unsigned long keyframeIntervalMs = 5000;
+
+// Stamp binary frames with millis() so the PC can measure transport latency
+const bool sendFrameTimestamps = false;
+
 // =================== Global Variables ===================
 
-// Arrays to store previous readings for comparison
-int potValues[numPotentiometers] = {};
+// Averaged potentiometer values and their changes
+volware::KnobSampler knobs(numPotentiometers, oversampleShift,
+                           noiseThreshold);
 byte muteValues[numPotentiometers] = {};
-byte previousButtonStates[numMuteButtons] = {};
+// At least one element, a zero-length array does not compile without
+// mute buttons
+volware::ButtonDebouncer muteButtons[numMuteButtons > 0 ? numMuteButtons : 1];
+
+// Schedules of the loop
+volware::Interval sampleTimer(sampleIntervalUs);
+volware::Interval frameTimer(frameIntervalMs);
+volware::Interval buttonTimer(buttonIntervalMs);
+
+// Changes collected for the next frame
+byte pendingMask = 0;
+bool syncRequested = false;
+
+// Protocol state
+volware::protocol::HostStateDecoder hostState; // PC -> device state
+bool binaryMode = false; // Send binary frames instead of ASCII lines
+byte frameSequence = 0;  // Sequence number of the next binary frame
+unsigned long lastKeyframeMs = 0; // When the last keyframe was sent
 
 /**
  * Sets up mute buttons with proper pin modes
@@ -47,7 +108,53 @@ void setupMuteButtons() {
         pinMode(muteLedPins[i], OUTPUT);   // Set mute LED pins as output
         digitalWrite(muteLedPins[i], LOW); // Initialize mute LEDs to off (LOW)
         muteValues[i] = 0; // Initialize mute values to 0 (not muted)
-        previousButtonStates[i] = LOW; // Initialize previous button states
+    }
+}
+
+/**
+ * Mute states of all channels as a bit mask, bit i for channel i
+ */
+byte muteBits() {
+    byte bits = 0;
+    for (int i = 0; i < numMuteButtons; i++) {
+        bits |= muteValues[i] << i;
+    }
+    return bits;
+}
+
+/**
+ * Sends an ASCII frame with all values and mute states
+ */
+void sendAsciiFrame() {
+    static char frame[volware::protocol::MAX_ASCII_FRAME_SIZE];
+
+    uint8_t length = volware::protocol::encodeAsciiFrame(
+        frame, knobs.values(), numPotentiometers, muteBits(),
+        numMuteButtons);
+    Serial.write((const uint8_t *)frame, length);
+}
+
+/**
+ * Sends a binary frame with the channels in changedMask, or a keyframe with
+ * all channels when keyframe is set
+ */
+void sendBinaryFrame(byte changedMask, bool keyframe) {
+    static uint8_t frame[volware::protocol::MAX_FRAME_SIZE];
+
+    byte mask = keyframe ? (1 << numPotentiometers) - 1 : changedMask;
+
+    uint8_t type = keyframe ? volware::protocol::FRAME_FULL
+                            : volware::protocol::FRAME_DELTA;
+    if (sendFrameTimestamps) {
+        type |= volware::protocol::FRAME_FLAG_TIME;
+    }
+    uint8_t length = volware::protocol::encodeFrame(
+        frame, type, frameSequence++, mask, muteBits(), knobs.values(),
+        millis());
+    Serial.write(frame, length);
+
+    if (keyframe) {
+        lastKeyframeMs = millis();
     }
 }
 
@@ -74,65 +181,132 @@ void setup() {
 }
 
 /**
- * Main program loop - runs continuously
- * Reads potentiometer values and sends updates when significant changes occur
+ * Takes over the state the PC reports for its channels. Nothing is sent
+ * back, the PC already knows it.
  */
-void loop() {
-    String msg; // Message that will be sent via serial if changes are detected
-    bool changed =
-        false; // Flag to track if any potentiometer changed significantly
-
-    // Check serial port for sync command
-    if (Serial.available()) {
-        char c = Serial.read(); // Read the incoming byte
-        if (c == 's') {
-            changed = true; // Set changed to true if 's' is received
+void applyHostState() {
+    for (int i = 0; i < numPotentiometers; i++) {
+        if (!(hostState.mask() & (1 << i))) {
+            continue;
+        }
+        knobs.setHostValue(i, hostState.value(i));
+        if (i < numMuteButtons) {
+            muteValues[i] = (hostState.muteBits() >> i) & 1;
+            digitalWrite(muteLedPins[i], muteValues[i] ? HIGH : LOW);
         }
     }
+}
 
-    // Read each potentiometer one by one
-    for (int i = 0; i < numPotentiometers; i++) {
-        delay(10);
+/**
+ * Handles the sync and protocol commands and the host state sent by the PC
+ */
+void handleCommands() {
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (hostState.feed(c)) {
+            if (hostState.ready()) {
+                applyHostState();
+            }
+        } else if (c == volware::protocol::REQUEST_SYNC) {
+            syncRequested = true;
+        } else if (c == volware::protocol::REQUEST_BINARY) {
+            binaryMode = true;
+        } else if (c == volware::protocol::REQUEST_ASCII) {
+            binaryMode = false;
+        }
+    }
+}
 
-        // Read the current position of the potentiometer (range: 0-1023)
-        int potReading = analogRead(potentiometerInputPins[i]);
-        byte muteReading = digitalRead(muteInputPins[i]);
+/**
+ * Sets the mute state and LED of a channel and marks it for the next frame
+ * if it changed
+ */
+void setMute(int channel, byte mute) {
+    if (muteValues[channel] == mute) {
+        return;
+    }
+    muteValues[channel] = mute;
+    digitalWrite(muteLedPins[channel], mute ? HIGH : LOW); // Update LED
+    pendingMask |= 1 << channel;
+}
 
-        // Check if value changed enough to be reported (beyond noise threshold)
-        if (abs(potValues[i] - potReading) >= noiseThreshold) {
-            potValues[i] = potReading; // Update stored value
-            changed = true;            // Mark that we have a significant change
+/**
+ * Runs the debouncers of all mute buttons. A press toggles the channel's
+ * mute state, a long press mutes all other channels and unmutes its own.
+ * Returns true if any mute state changed.
+ */
+bool pollMuteButtons() {
+    byte before = muteBits();
+    unsigned long nowMs = millis();
+    for (int i = 0; i < numMuteButtons; i++) {
+        // Buttons pull the pin LOW when pressed
+        bool pressed = digitalRead(muteInputPins[i]) == LOW;
+        switch (muteButtons[i].update(pressed, nowMs, buttonTiming)) {
+        case volware::BUTTON_PRESSED:
+            setMute(i, muteValues[i] == 0 ? 1 : 0); // Toggle mute state
+            break;
+        case volware::BUTTON_LONG_PRESS:
+            for (int j = 0; j < numMuteButtons; j++) {
+                setMute(j, j == i ? 0 : 1);
+            }
+            break;
+        default:
+            break;
         }
+    }
+    return muteBits() != before;
+}
 
-        // Check if mute button pressed
-        if (previousButtonStates[i] == HIGH && muteReading == LOW && numMuteButtons > 0) {
-            muteValues[i] = muteValues[i] == 0 ? 1 : 0; // Toggle mute state
-            digitalWrite(muteLedPins[i],
-                         muteValues[i] == 1 ? HIGH : LOW); // Update LED
-            changed = true; // Mark that we have a significant change
+/**
+ * Sends the current state in the active format
+ */
+void sendFrame() {
+    if (binaryMode) {
+        bool keyframeDue = millis() - lastKeyframeMs >= keyframeIntervalMs;
+        if (syncRequested || keyframeDue) {
+            sendBinaryFrame(pendingMask, true);
+        } else if (pendingMask) {
+            sendBinaryFrame(pendingMask, false);
         }
-
-        // Update previous button state for next loop iteration
-        previousButtonStates[i] = muteReading;
+        return;
     }
 
-    // Build the output message with all current values
-    // Format: "value1,value2,...,mute1,mute2,...\n"
-    for (int i = 0; i < numPotentiometers; i++) {
-        msg += String(potValues[i]); // Append potentiometer value to message
-        msg += ",";                  // Add comma separator
+    // Only send data when at least one value has changed significantly
+    if (pendingMask || syncRequested) {
+        sendAsciiFrame();
     }
+}
 
-    for (int i = 0; i < numMuteButtons; i++) {
-        msg += String(muteValues[i]); // Append mute value to message
-        msg += ",";                   // Add comma separator
+/**
+ * Sends everything collected since the last frame
+ */
+void flushFrame() {
+    pendingMask |= knobs.takeChanged();
+    sendFrame();
+    pendingMask = 0;
+    syncRequested = false;
+}
+
+/**
+ * Main program loop - runs continuously
+ * Takes one potentiometer reading per sample interval and sends the
+ * changes collected so far once per frame interval, or at once when a
+ * mute state changed
+ */
+void loop() {
+    handleCommands();
+
+    if (sampleTimer.due(micros())) {
+        byte channel = knobs.channel();
+        knobs.addReading(analogRead(potentiometerInputPins[channel]));
     }
 
-    msg.remove(msg.length() - 1); // Remove the last comma
-    msg += "\n";                  // Add newline character at the end
+    bool muteChanged = false;
+    if (numMuteButtons > 0 && buttonTimer.due(millis())) {
+        muteChanged = pollMuteButtons();
+    }
 
-    // Only send data when at least one value has changed significantly
-    if (changed) {
-        Serial.print(msg); // Send the formatted message
+    if (frameTimer.due(millis()) || muteChanged) {
+        flushFrame();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+// How knob values are smoothed before they are applied
+enum class FilterMode {
+    None,   // Raw values
+    Ema,    // Exponential moving average with a fixed time constant
+    OneEuro // One-euro filter: smooth when still, responsive when turned
+};
+
+struct FilterSettings {
+    FilterMode mode = FilterMode::None;
+    double timeConstantMs = 20.0; // Ema
+    double minCutoffHz = 1.0;     // OneEuro, smoothing at rest
+    double beta = 0.05;           // OneEuro, cutoff increase with speed
+    double derivativeCutoffHz = 1.0;
+    int hysteresis = 0; // Ignore changes smaller than this, in raw steps
+    int deadzone = 0;   // Raw steps at each end that snap to the end
+};
+
+/**
+ * ChannelFilter - Smoothing, deadzone and hysteresis for one knob
+ *
+ * Takes the raw 10-bit values of one channel with their receive times and
+ * decides which of them are worth applying. The filters are time-based, so
+ * the sparse, change-only frames of the device are weighted by the time
+ * between them; a value that arrives after a pause is taken almost as is.
+ * The output is a raw value again, with the deadzones stretched away so
+ * the remaining travel still covers the full range.
+ */
+class ChannelFilter {
+public:
+    static constexpr int MAX_VALUE = 1023;
+
+    // The value to apply, or nothing if it would not differ enough from
+    // the last one returned
+    std::optional<int> process(int value, std::uint64_t timeUs,
+                               const FilterSettings &settings);
+
+    // The last value returned, -1 before the first
+    int output() const { return m_output; }
+
+private:
+    double smooth(double value, double dtSeconds,
+                  const FilterSettings &settings);
+
+    bool m_started = false;
+    std::uint64_t m_lastTimeUs = 0;
+    double m_value = 0.0;      // Filter state
+    double m_derivative = 0.0; // OneEuro speed estimate
+    int m_output = -1;         // Last value returned
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * ChannelLimits - Number of channels over all devices
+ *
+ * Each device's channels follow those of the devices before it, and every
+ * stage between the serial readers and the volume backend keeps state for
+ * this many global channels. Config rejects layouts that need more.
+ */
+constexpr int MAX_GLOBAL_CHANNELS = 24;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ChannelLimits.h"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * ChannelSync - Decides whether a channel follows its knob or a change
+ * made by another program
+ *
+ * When another program changes the volume of a channel's targets, the
+ * channel is detached from its knob. The device keeps repeating the knob's
+ * old position in keyframes, sync answers and the frames of other
+ * channels, and those repeats must not undo the change, so values within
+ * PICKUP_THRESHOLD of where the knob was are dropped until it is actually
+ * turned. A mute state changed elsewhere is likewise kept until the device
+ * reports a different one. The new state is also queued for the device,
+ * which shows it on its LEDs and parks the knob the same way (see the host
+ * state message in VolwareProtocol.h).
+ *
+ * Not thread-safe; meant for the applier thread.
+ */
+class ChannelSync {
+public:
+    static constexpr int MAX_CHANNELS = MAX_GLOBAL_CHANNELS;
+
+    struct Decision {
+        bool volume; // Apply the knob's volume
+        bool mute;   // Apply the device's mute state
+    };
+
+    // A value from the device, after filtering; mute is negative when the
+    // device does not report it
+    Decision deviceUpdate(int channel, int value, int mute);
+
+    // Another program set the channel to the volume of knob position value
+    // and to mute
+    void externalChange(int channel, int value, bool mute);
+
+    // Channels changed by other programs since the last call, bit i for
+    // channel i, with their new state below
+    std::uint32_t takeHostChanges();
+    int hostValue(int channel) const { return m_channels[channel].hostValue; }
+    bool hostMute(int channel) const { return m_channels[channel].hostMute; }
+
+private:
+    struct Channel {
+        int knobValue = -1; // Last value applied from the device
+        int knobMute = -1;  // Last mute state reported by the device
+        bool volumeDetached = false;
+        bool muteDetached = false;
+        int hostValue = 0;
+        bool hostMute = false;
+    };
+
+    std::array<Channel, MAX_CHANNELS> m_channels;
+    std::uint32_t m_hostChanges = 0;
+};
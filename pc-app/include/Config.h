@@ -1,22 +1,70 @@
 #pragma once
 
+#include "ChannelFilter.h"
+#include "ChannelLimits.h"
+#include "DispatchTable.h"
+#include "ResponseCurve.h"
+
+#include <cstddef>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <yaml-cpp/yaml.h>
 
+// One mixer board. Its channels occupy the global channels channelOffset to
+// channelOffset + channelCount - 1.
+struct DeviceConfig {
+    // muteButtonCount of a board with one mute button per knob
+    static constexpr int MUTE_PER_CHANNEL = -1;
+
+    std::string comPort;
+    int baudRate;
+    std::unordered_map<int, std::vector<std::string>> channelApps; // Local
+    int channelOffset = 0;
+    int channelCount = 0; // Highest mapped local channel + 1
+    int muteButtonCount = 0; // Mute states at the end of an ASCII frame
+
+    // Channel values at the front of an ASCII frame with fieldCount fields
+    std::size_t asciiValueCount(std::size_t fieldCount) const {
+        if (muteButtonCount == MUTE_PER_CHANNEL) {
+            return fieldCount / 2;
+        }
+        std::size_t muteCount = static_cast<std::size_t>(muteButtonCount);
+        return fieldCount > muteCount ? fieldCount - muteCount : 0;
+    }
+};
+
 class Config {
 public:
     Config();
     explicit Config(const std::string &configFilePath);
 
-    // Accessors
-    const std::string &getComPort() const { return m_comPort; }
-    int getBaudRate() const { return m_baudRate; }
+    const std::string &getConfigFilePath() const { return m_configFilePath; }
+
+    // Accessors; the port and baud rate are those of the first device
+    const std::string &getComPort() const { return m_devices.front().comPort; }
+    int getBaudRate() const { return m_devices.front().baudRate; }
+    const std::vector<DeviceConfig> &getDevices() const { return m_devices; }
     bool isMuteButtons() const { return m_muteButtons; }
     bool isInvertSlider() const { return m_invertSlider; }
     bool isAutoStart() const { return m_autoStart; }
+    bool isBinaryProtocol() const { return m_binaryProtocol; }
 
+    // Latency tracing; disabled when both are unset
+    unsigned int getLatencyLogIntervalMs() const {
+        return m_latencyLogIntervalMs;
+    }
+    const std::string &getLatencyTraceFile() const {
+        return m_latencyTraceFile;
+    }
+    bool isLatencyTracing() const {
+        return m_latencyLogIntervalMs > 0 || !m_latencyTraceFile.empty();
+    }
+
+    // Localhost port of the Prometheus metrics endpoint, 0 when disabled
+    unsigned short getMetricsPort() const { return m_metricsPort; }
+
+    // Applications of every device, keyed by global channel
     const std::unordered_map<int, std::vector<std::string>> &
     getChannelApps() const {
         return m_channelApps;
@@ -24,17 +72,38 @@ public:
 
     int getChannelCount() const { return m_channelApps.size(); }
 
+    // Knob value processing; the curve includes invert_slider
+    const FilterSettings &getFilterSettings() const { return m_filterSettings; }
+    const ResponseCurve &getResponseCurve() const { return m_responseCurve; }
+
+    // channel_apps compiled for frame dispatch, by global channel
+    const DispatchTable &getDispatchTable() const { return m_dispatchTable; }
+
+    // Take the devices and their channel mapping over from previous, for a
+    // reload that may not change them while their readers are running
+    void keepDevices(const Config &previous);
+
 private:
     void loadConfig();
+    static DeviceConfig parseDevice(const YAML::Node &node,
+                                    int muteButtonCount);
+    static int parseMuteButtons(const YAML::Node &node);
+    void parseSignal(const YAML::Node &node, CurveSettings &curve);
 
     // Configuration file path
     std::string m_configFilePath;
 
     // Configuration parameters
-    std::string m_comPort;
-    int m_baudRate;
+    std::vector<DeviceConfig> m_devices;
     bool m_muteButtons;
     bool m_invertSlider;
     bool m_autoStart;
+    bool m_binaryProtocol = false;
+    unsigned int m_latencyLogIntervalMs = 0;
+    std::string m_latencyTraceFile;
+    unsigned short m_metricsPort = 0;
     std::unordered_map<int, std::vector<std::string>> m_channelApps;
+    DispatchTable m_dispatchTable;
+    FilterSettings m_filterSettings;
+    ResponseCurve m_responseCurve;
 };
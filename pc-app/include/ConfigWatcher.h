@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Config.h"
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <thread>
+
+/**
+ * ConfigWatcher - Reloads the configuration file when it changes
+ *
+ * Watches the directory of the config file (inotify on Linux, change
+ * notifications on Windows) and loads the file again on its own thread
+ * after it was written. The thread sleeps until the directory changes or
+ * stop() is called, so it costs no wakeups while idle. Each successful
+ * load is published as a new immutable Config snapshot that readers fetch
+ * with current(). The snapshot is swapped through an
+ * std::atomic<std::shared_ptr>, which libstdc++ and MSVC implement with a
+ * short internal lock held only for the pointer and reference count
+ * update, never while a file is loaded. A file that fails to load is
+ * reported and the previous snapshot stays in effect.
+ *
+ * Settings that need a new connection only take effect after a restart.
+ * If a reload changes the devices, their number, ports or baud rates, the
+ * devices and their channel mapping are kept from the previous snapshot
+ * and only the other settings are applied.
+ */
+class ConfigWatcher {
+public:
+    using ReloadCallback =
+        std::function<void(const std::shared_ptr<const Config> &config)>;
+
+    explicit ConfigWatcher(std::shared_ptr<const Config> config);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher &) = delete;
+    ConfigWatcher &operator=(const ConfigWatcher &) = delete;
+
+    bool start();
+    void stop();
+
+    // Called on the watcher thread after a new snapshot was published
+    void setReloadCallback(ReloadCallback callback) {
+        m_callback = std::move(callback);
+    }
+
+    std::shared_ptr<const Config> current() const {
+        return m_config.load(std::memory_order_acquire);
+    }
+
+    // Load the file now; false if it failed and the snapshot was kept
+    bool reload();
+
+private:
+    // Editors write in several steps, so wait for the file to settle
+    static constexpr int SETTLE_DELAY_MS = 100;
+    static constexpr int POLL_INTERVAL_MS = 250; // Without a watch
+
+    void watchThread(std::stop_token stopToken);
+
+    std::filesystem::path m_path;
+    std::atomic<std::shared_ptr<const Config>> m_config;
+    ReloadCallback m_callback;
+    std::jthread m_thread;
+};
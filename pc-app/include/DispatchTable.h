@@ -0,0 +1,62 @@
+#pragma once
+
+#include "AppMatcher.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * DispatchTable - Channel to volume target mapping compiled from the config
+ *
+ * Every application name or pattern in channel_apps is lowercased and
+ * interned once into a target ID. Entries starting with '!' exclude
+ * applications from the channel's patterns instead; a pattern listed on
+ * several channels takes the exclusions of all of them. The targets are
+ * compiled into an AppMatcher, with "unmapped" standing for every
+ * application no other entry matches. Channels are stored densely by channel
+ * number with their target IDs laid out back to back and "master" resolved
+ * to a flag, so dispatching a frame needs no hashing and no string
+ * handling. Immutable once built.
+ */
+class DispatchTable {
+public:
+    using TargetId = AppMatcher::TargetId;
+
+    struct Channel {
+        std::uint32_t firstTarget = 0; // Into the shared target ID array
+        std::uint32_t targetCount = 0;
+        bool master = false; // Also controls the master volume
+        bool mapped = false; // Listed in channel_apps
+    };
+
+    DispatchTable() = default;
+    explicit DispatchTable(
+        const std::unordered_map<int, std::vector<std::string>> &channelApps);
+
+    // Channels 0 to channelCount() - 1; unlisted ones are not mapped
+    int channelCount() const { return static_cast<int>(m_channels.size()); }
+
+    bool isMapped(int channel) const {
+        return channel >= 0 && channel < channelCount() &&
+               m_channels[channel].mapped;
+    }
+
+    // The channel must be below channelCount()
+    const Channel &channel(int channel) const { return m_channels[channel]; }
+
+    std::span<const TargetId> targets(const Channel &channel) const {
+        return std::span(m_targetIds).subspan(channel.firstTarget,
+                                              channel.targetCount);
+    }
+
+    // Matcher from process name to target ID
+    const AppMatcher &matcher() const { return m_matcher; }
+
+private:
+    std::vector<Channel> m_channels;
+    std::vector<TargetId> m_targetIds;
+    AppMatcher m_matcher;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "FrameParser.h"
+#include "VolwareProtocol.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/**
+ * SerialFrame - One decoded frame from the device
+ *
+ * values uses the ASCII layout: channel values followed by mute states.
+ * Delta frames are merged into the state of the last keyframe, so values
+ * always holds every channel; changedChannels tells which ones moved.
+ * Binary frames say how many of the values are channel values; an ASCII
+ * line does not, its layout depends on the board's mute buttons.
+ */
+struct SerialFrame {
+    static constexpr std::uint32_t ALL_CHANNELS = ~std::uint32_t{0};
+    static constexpr int UNKNOWN_VALUE_COUNT = -1;
+
+    std::span<const int> values;
+    int valueCount = UNKNOWN_VALUE_COUNT; // Channel values at the front
+    std::uint32_t changedChannels = ALL_CHANNELS; // Bit i: channel i changed
+    bool keyframe = true;                         // Carries the full state
+
+    // Timing, for latency tracing
+    bool hasDeviceTime = false;     // deviceTimeMs was sent by the device
+    std::uint32_t deviceTimeMs = 0; // Device millis() when sampled
+    std::uint64_t receivedUs = 0;   // LatencyTracer::nowUs() at receive
+};
+
+/**
+ * FrameDecoder - Incremental decoder for the device's serial frames
+ *
+ * Accepts both ASCII lines and binary frames (see VolwareProtocol.h) from
+ * the same byte stream. Binary frames are recognised by their sync byte and
+ * validated with their CRC; once a valid binary frame has been seen, stray
+ * bytes are skipped instead of being parsed as ASCII.
+ */
+class FrameDecoder {
+public:
+    struct Result {
+        std::size_t consumed = 0; // Bytes to drop from the input
+        bool frameReady = false;  // frame() holds a new frame
+    };
+
+    struct Stats {
+        std::uint32_t framesDecoded = 0;
+        std::uint32_t corruptFrames = 0;
+        std::uint32_t droppedFrames = 0;
+        std::uint32_t discardedBytes = 0;
+        std::uint32_t skippedDeltas = 0; // Deltas received before a keyframe
+    };
+
+    // Decode from the front of data. consumed is zero when more input is
+    // needed to make progress.
+    Result decode(std::string_view data);
+
+    // Last decoded frame, valid until the next decode()
+    const SerialFrame &frame() const { return m_frame; }
+
+    const Stats &stats() const { return m_stats; }
+    bool isBinary() const { return m_binary; }
+
+    // Forget stream state, e.g. after reconnecting
+    void reset();
+
+private:
+    // ASCII lines longer than this are treated as garbage
+    static constexpr std::size_t MAX_LINE_LENGTH = 256;
+
+    Result decodeBinary(std::string_view data);
+    Result decodeAscii(std::string_view data);
+
+    FrameParser m_parser;
+    std::array<int, FrameParser::MAX_VALUES> m_binaryValues{};
+    SerialFrame m_frame;
+
+    // Channel state accumulated from binary keyframes and deltas
+    std::array<std::uint16_t, volware::protocol::MAX_CHANNELS>
+        m_channelValues{};
+    std::uint8_t m_keyframeMask = 0;
+    std::uint8_t m_muteBits = 0;
+
+    bool m_binary = false;
+    bool m_haveSequence = false;
+    std::uint8_t m_lastSequence = 0;
+    Stats m_stats;
+};
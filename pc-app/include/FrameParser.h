@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+/**
+ * FrameParser - Allocation-free parser for serial input frames
+ *
+ * Parses comma-separated lines such as "1023,512,0,1" into a fixed-capacity
+ * value buffer that is reused from frame to frame, so steady-state parsing
+ * never touches the heap. Fields that are not valid integers are skipped.
+ */
+class FrameParser {
+public:
+    // Maximum number of values kept per frame; extra fields are dropped
+    static constexpr std::size_t MAX_VALUES = 32;
+
+    // Parse one line (newline excluded). The returned view stays valid
+    // until the next call to parse().
+    std::span<const int> parse(std::string_view line);
+
+private:
+    std::array<int, MAX_VALUES> m_values{};
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * LatencyHistogram - Lock-free log-linear histogram of microsecond values
+ *
+ * Four buckets per power of two, so percentiles are reported with at most
+ * 25% error. Recording is a single relaxed atomic increment.
+ */
+class LatencyHistogram {
+public:
+    struct Summary {
+        std::uint64_t count = 0;
+        std::uint64_t p50Us = 0;
+        std::uint64_t p99Us = 0;
+        std::uint64_t maxUs = 0;
+    };
+
+    void record(std::uint64_t valueUs);
+    Summary summarize() const;
+    void reset();
+
+private:
+    static constexpr int SUB_BUCKETS = 4;
+    static constexpr int BUCKET_COUNT = 160;
+
+    static int bucketIndex(std::uint64_t valueUs);
+    static std::uint64_t bucketUpperBound(int index);
+
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> m_buckets{};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+/**
+ * LatencyTracer - Knob-to-volume latency tracing
+ *
+ * Records how long each stage between a frame arriving on the serial port
+ * and the audio backend call returning takes. Results are available as
+ * p50/p99/max histograms, logged periodically, and optionally as Chrome
+ * trace events (chrome://tracing, Perfetto). Tracing is off until enabled
+ * and costs a single atomic load per hook while off.
+ */
+class LatencyTracer {
+public:
+    enum class Stage {
+        Transport, // Device timestamp to receive, above the device's lowest
+        Parse,     // Decoding one frame
+        Dispatch,  // Input callback for one frame
+        Queue,     // Receive to the applier picking the channel up
+        Backend,   // One audio backend call
+        EndToEnd,  // Receive to the channel's backend calls finished
+        Count
+    };
+
+    // Transport baseline of one device: the lowest device-to-host clock
+    // offset seen. Every device's millis() has its own epoch, so each
+    // reader keeps one and resets it when the device may have restarted.
+    struct DeviceClock {
+        std::int64_t minOffsetUs = INT64_MAX;
+
+        void reset() { minOffsetUs = INT64_MAX; }
+    };
+
+    static LatencyTracer &global();
+
+    ~LatencyTracer();
+
+    // Start collecting. A non-zero interval logs a summary line that often;
+    // a non-empty path keeps trace events and writes them there on stop().
+    void enable(unsigned int logIntervalMs, const std::string &chromeTracePath);
+    void stop();
+    bool isEnabled() const {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Monotonic clock shared by all hooks
+    static std::uint64_t nowUs();
+
+    // Hooks; no-ops while tracing is disabled
+    void record(Stage stage, std::uint64_t startUs, std::uint64_t endUs);
+    void recordDeviceTime(DeviceClock &clock, std::uint32_t deviceMs,
+                          std::uint64_t receivedUs);
+
+    LatencyHistogram::Summary summarize(Stage stage) const;
+    void writeSummary(std::ostream &out) const;
+    bool writeChromeTrace(const std::string &path) const;
+
+private:
+    struct TraceEvent {
+        std::uint64_t startUs;
+        std::uint32_t durationUs;
+        std::uint16_t stage;
+        std::uint16_t thread;
+    };
+
+    static constexpr std::size_t MAX_TRACE_EVENTS = 1 << 16;
+
+    static const char *stageName(Stage stage);
+    static std::uint16_t threadNumber();
+    void reportThread(std::stop_token stopToken, unsigned int intervalMs);
+
+    std::atomic<bool> m_enabled{false};
+    std::array<LatencyHistogram, static_cast<int>(Stage::Count)> m_histograms;
+
+    // Trace events, kept until the buffer is full
+    std::string m_chromeTracePath;
+    std::unique_ptr<TraceEvent[]> m_events;
+    std::atomic<std::size_t> m_eventCount{0};
+
+    // Periodic summary logging
+    std::mutex m_reportMutex;
+    std::condition_variable_any m_reportCondition;
+    std::jthread m_reportThread;
+};
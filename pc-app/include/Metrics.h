@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * MetricCounter - Monotonic counter; adding is a single relaxed atomic
+ * increment
+ */
+class MetricCounter {
+public:
+    void add(std::uint64_t count = 1) {
+        m_value.fetch_add(count, std::memory_order_relaxed);
+    }
+    std::uint64_t value() const {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> m_value{0};
+};
+
+/**
+ * MetricHistogram - Distribution of microsecond values over fixed bucket
+ * bounds, exported in seconds. Recording is a binary search over the
+ * bounds and two relaxed atomic additions.
+ */
+class MetricHistogram {
+public:
+    explicit MetricHistogram(std::span<const std::uint64_t> boundsUs);
+
+    void record(std::uint64_t valueUs);
+
+    // Bucket bounds in microseconds; bucket i counts values up to bound i,
+    // the last bucket the values above every bound
+    std::span<const std::uint64_t> boundsUs() const { return m_boundsUs; }
+    std::uint64_t bucketCount(std::size_t bucket) const {
+        return m_buckets[bucket].load(std::memory_order_relaxed);
+    }
+    std::uint64_t sumUs() const {
+        return m_sumUs.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<std::uint64_t> m_boundsUs;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_buckets;
+    std::atomic<std::uint64_t> m_sumUs{0};
+};
+
+/**
+ * MetricsRegistry - Named counters and histograms of the running
+ * application
+ *
+ * Components look their metrics up once, typically in their constructor,
+ * and keep the reference; metrics are never removed, so the references
+ * stay valid, and updating them takes no lock. Only registration and
+ * export lock the registry. Names follow the Prometheus conventions, and
+ * writePrometheus() produces the Prometheus text exposition format.
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry &global();
+
+    // Look up or register a metric. labels is a preformatted label list
+    // such as label("port", "COM3"); a name keeps the help text and, for
+    // histograms, the bounds it was first registered with.
+    MetricCounter &counter(std::string_view name, std::string_view help,
+                           std::string_view labels = {});
+    MetricHistogram &histogram(std::string_view name, std::string_view help,
+                               std::span<const std::uint64_t> boundsUs,
+                               std::string_view labels = {});
+
+    // Format one label, escaping the value
+    static std::string label(std::string_view name, std::string_view value);
+
+    void writePrometheus(std::ostream &out) const;
+
+private:
+    struct Series {
+        std::string labels;
+        MetricCounter *counter = nullptr;
+        MetricHistogram *histogram = nullptr;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        bool histogram;
+        std::vector<Series> series;
+    };
+
+    Series &findSeries(std::string_view name, std::string_view help,
+                       bool histogram, std::string_view labels);
+
+    mutable std::mutex m_mutex;
+    std::vector<Family> m_families; // In registration order
+    std::deque<MetricCounter> m_counters;
+    std::deque<MetricHistogram> m_histograms;
+};
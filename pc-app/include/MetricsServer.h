@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Metrics.h"
+
+#include <memory>
+
+/**
+ * MetricsServer - Serves a MetricsRegistry over HTTP on localhost
+ *
+ * Answers GET /metrics on 127.0.0.1 with the registry in the Prometheus
+ * text format, so a local Prometheus agent or curl can scrape the running
+ * application. It runs on a thread of its own and reads the metrics without
+ * stopping the components that update them. Only the loopback interface is
+ * bound; the endpoint is not meant to be reachable from other machines.
+ */
+class MetricsServer {
+public:
+    MetricsServer(MetricsRegistry &registry, unsigned short port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+    // Returns false if the port cannot be bound
+    bool start();
+    void stop();
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
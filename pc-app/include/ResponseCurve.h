@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+// Mapping from knob position to volume
+enum class CurveType {
+    Linear,      // Volume follows the knob
+    Logarithmic, // Equal knob travel gives equal steps in dB
+    Table        // Points spread evenly over the travel, interpolated
+};
+
+struct CurveSettings {
+    CurveType type = CurveType::Linear;
+    double rangeDb = 60.0;      // Logarithmic: attenuation just above zero
+    std::vector<double> points; // Table: volumes from 0.0 to 1.0
+};
+
+/**
+ * ResponseCurve - Knob value to volume level lookup table
+ *
+ * Evaluates the configured curve once for every 10-bit knob value, with
+ * the slider direction already applied, so turning a value into a volume
+ * level is a single table read. The linear and logarithmic curves map the
+ * ends of the travel to exactly 0.0 and 1.0.
+ */
+class ResponseCurve {
+public:
+    static constexpr int SIZE = 1024;
+
+    ResponseCurve() : ResponseCurve(CurveSettings{}, false) {}
+    ResponseCurve(const CurveSettings &settings, bool invert);
+
+    float operator[](int value) const {
+        return m_table[value < 0 ? 0 : value >= SIZE ? SIZE - 1 : value];
+    }
+
+    // The knob value whose volume is closest to volumeLevel, for showing a
+    // volume set elsewhere on the device
+    int position(float volumeLevel) const;
+
+private:
+    std::array<float, SIZE> m_table;
+};
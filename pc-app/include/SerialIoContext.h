@@ -0,0 +1,32 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * SerialIoContext - I/O threads shared by all serial readers
+ *
+ * Owns the io_context every SerialReader runs on, and the threads that run
+ * it. One thread serves any number of devices, since the readers only wake
+ * up for incoming data and timers. Stop the readers before stopping this.
+ */
+class SerialIoContext {
+public:
+    explicit SerialIoContext(unsigned int threadCount = 1);
+    ~SerialIoContext();
+
+    boost::asio::io_context &context() { return m_ioContext; }
+
+    void start();
+    void stop();
+
+private:
+    unsigned int m_threadCount;
+    boost::asio::io_context m_ioContext;
+    std::optional<boost::asio::executor_work_guard<
+        boost::asio::io_context::executor_type>>
+        m_workGuard;
+    std::vector<std::jthread> m_threads;
+};
@@ -1,67 +1,162 @@
 #pragma once
 
+#include "FrameDecoder.h"
+#include "LatencyTracer.h"
+#include "Metrics.h"
+
+#include <array>
 #include <atomic>
 #include <boost/asio.hpp>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <random>
+#include <span>
 #include <string>
-#include <thread>
-#include <vector>
 
-// Define callback type for serial input processing
-using SerialInputCallback = std::function<void(const std::vector<int> &)>;
+// Define callback type for serial input processing. The frame is only
+// valid for the duration of the call.
+using SerialInputCallback = std::function<void(const SerialFrame &)>;
+
+// Wire format requested from the device during the sync handshake
+enum class SerialProtocol { Ascii, Binary };
 
+/**
+ * SerialReader - Reads frames from one device
+ *
+ * Everything runs asynchronously on a shared io_context (see
+ * SerialIoContext), serialised by a strand so the context may have several
+ * threads: reads, the sync timer and reconnecting. A lost port is retried
+ * with exponential backoff and jitter; on Linux the port's directory is
+ * also watched with inotify, so a replugged device is reopened as soon as
+ * its node appears. The full state is requested when the port opens and
+ * on requestSync(), and the request is repeated until the device answers,
+ * since a board that resets on open misses the first one. While the port
+ * is healthy the reader only wakes up for incoming data and requests.
+ * Frame, error and reconnect counts are exported with the port as label.
+ *
+ * The io_context must keep running until stop() has returned.
+ */
 class SerialReader {
 public:
-    SerialReader(const std::string &port, unsigned int baudRate);
+    SerialReader(boost::asio::io_context &ioContext, const std::string &port,
+                 unsigned int baudRate);
     ~SerialReader();
 
     bool start();
     void stop();
     bool isConnected() const { return m_connected; }
 
+    // Ask the device for its full state now, e.g. after a remap; may be
+    // called from any thread while the reader is running
+    void requestSync();
+
+    // Tell the device the PC's state of the channels in mask, e.g. after
+    // another program changed a volume; values and mute bits are indexed by
+    // the device's channel. May be called from any thread.
+    void sendHostState(std::uint8_t mask, std::uint8_t muteBits,
+                       std::span<const int> values);
+
     void setCallback(SerialInputCallback callback) {
         m_callback = std::move(callback);
     }
     void setSyncMessage(const std::string &syncMsg) { m_syncMessage = syncMsg; }
+    void setProtocol(SerialProtocol protocol) { m_protocol = protocol; }
 
 private:
     // Constants
-    static constexpr unsigned int RECONNECT_INTERVAL_MS = 1000;
-    static constexpr unsigned int SYNC_INTERVAL_MS = 1000;
+    static constexpr unsigned int RECONNECT_MIN_DELAY_MS = 50;
+    static constexpr unsigned int RECONNECT_MAX_DELAY_MS = 1000;
+    static constexpr unsigned int SYNC_RETRY_MS = 500;
+    static constexpr unsigned int SYNC_MAX_ATTEMPTS = 10;
 
     // Port operations
     bool openPort();
     bool closePort();
 
+    // Reconnecting, all on the I/O thread
+    void connect();
+    void scheduleReconnect();
+    void handleDisconnect();
+
+    // Device arrival detection (Linux only, no-op elsewhere)
+    void watchDevice();
+    void readDeviceEvents();
+
     // Message handling
     void sendMessage(const std::string &message,
                      std::function<void(bool success)> callback = nullptr);
     void sendSyncMessage();
-    void scheduleSyncTimer();
+    void scheduleSyncRetry();
 
     // Reading operations
     void readStart();
     void readComplete(const boost::system::error_code &error,
                       size_t bytesTransferred);
 
-    // Thread management
-    void workerThread();
+    // Wraps a completion handler so stop() can wait until it has run
+    template <typename Handler> auto tracked(Handler handler) {
+        {
+            std::lock_guard<std::mutex> lock(m_operationMutex);
+            m_operations++;
+        }
+        return [this, handler = std::move(handler)](auto &&...args) mutable {
+            handler(std::forward<decltype(args)>(args)...);
+            std::lock_guard<std::mutex> lock(m_operationMutex);
+            if (--m_operations == 0) {
+                m_operationsDone.notify_all();
+            }
+        };
+    }
 
     // Configuration
     std::string m_portName;
     unsigned int m_baudRate;
     std::string m_syncMessage;
+    SerialProtocol m_protocol = SerialProtocol::Ascii;
     SerialInputCallback m_callback;
 
-    // Boost ASIO objects
-    boost::asio::io_service m_ioService;
+    // Boost ASIO objects, all bound to the strand
+    boost::asio::strand<boost::asio::io_context::executor_type> m_strand;
     boost::asio::serial_port m_serialPort;
     boost::asio::streambuf m_readBuffer;
+    FrameDecoder m_frameDecoder;
+    LatencyTracer::DeviceClock m_deviceClock; // Transport baseline
+    std::uint32_t m_reportedFrameErrors = 0;
+
+    // Exported counters, labelled with the port
+    struct PortMetrics {
+        explicit PortMetrics(const std::string &port);
+
+        MetricCounter &frames;
+        MetricCounter &corruptFrames;
+        MetricCounter &droppedFrames;
+        MetricCounter &discardedBytes;
+        MetricCounter &reconnects;
+    };
+    PortMetrics m_metrics;
+    FrameDecoder::Stats m_exportedStats; // Decoder counts already exported
     std::unique_ptr<boost::asio::steady_timer> m_syncTimer;
+    unsigned int m_syncAttempts = 0; // Requests sent without an answer
+
+    // Reconnect state
+    boost::asio::steady_timer m_reconnectTimer;
+    unsigned int m_reconnectAttempts = 0;
+    std::minstd_rand m_random{std::random_device{}()};
+
+#ifdef __linux__
+    // inotify descriptor watching the port's directory
+    boost::asio::posix::stream_descriptor m_deviceWatch;
+    alignas(8) std::array<char, 1024> m_deviceEvents;
+#endif
+
+    // Handlers still queued or in flight
+    std::mutex m_operationMutex;
+    std::condition_variable m_operationsDone;
+    unsigned int m_operations = 0;
 
-    // Thread and state
-    std::jthread m_workerThread;
+    // State
     std::atomic<bool> m_running{false};
     std::atomic<bool> m_connected{false};
-};
\ No newline at end of file
+};
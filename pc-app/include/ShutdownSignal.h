@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#endif
+
+/**
+ * ShutdownSignal - Blocks the main thread until the application should exit
+ *
+ * wait() sleeps in the kernel until a shutdown is requested, without any
+ * timeout, so an idle application never wakes up its main thread. On
+ * Linux it waits on a signalfd for SIGINT and SIGTERM and on an eventfd
+ * for request(). On Windows it waits with MsgWaitForMultipleObjects on an
+ * event and the thread's message queue, dispatching window messages such
+ * as the tray icon's in between; WM_QUIT and console Ctrl+C also end the
+ * wait.
+ *
+ * Other POSIX systems use a signal handler writing to a pipe instead.
+ *
+ * On Linux, construct it before starting any other thread: the signals are
+ * blocked in the constructing thread and only threads created afterwards
+ * inherit that mask, so a signal could otherwise go to another thread and
+ * terminate the process.
+ */
+class ShutdownSignal {
+public:
+    ShutdownSignal();
+    ~ShutdownSignal();
+
+    ShutdownSignal(const ShutdownSignal &) = delete;
+    ShutdownSignal &operator=(const ShutdownSignal &) = delete;
+
+    // Ask wait() to return; may be called from any thread
+    void request();
+    bool isRequested() const { return m_requested; }
+
+    // Block until request(), a termination signal or WM_QUIT
+    void wait();
+
+private:
+    std::atomic<bool> m_requested = false;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE m_event = NULL;
+#elif defined(__linux__)
+    int m_signalFd = -1;
+    int m_eventFd = -1;
+#else
+    int m_pipe[2] = {-1, -1};
+#endif
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ChannelLimits.h"
+#include "Metrics.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <thread>
+
+/**
+ * VolumeApplier - Latest-value-wins stage between input and volume backend
+ *
+ * The serial reader posts channel values into per-channel atomic slots and
+ * never blocks; a dedicated thread drains the slots and applies everything
+ * pending as one batch. When the backend is slower than the input,
+ * intermediate positions of a channel are overwritten and only the newest
+ * one is applied.
+ */
+class VolumeApplier {
+public:
+    static constexpr int MAX_CHANNELS = MAX_GLOBAL_CHANNELS;
+    static constexpr int NO_MUTE = -1;
+
+    struct Update {
+        int channel;
+        int value;
+        int mute; // Last mute state posted, NO_MUTE if there was none
+    };
+
+    // Applies a batch of channels, each at most once; runs on the applier
+    // thread. The batch is empty after a wake().
+    using ApplyFunction = std::function<void(std::span<const Update>)>;
+
+    struct Stats {
+        std::uint64_t framesReceived = 0;
+        std::uint64_t updatesPosted = 0;
+        std::uint64_t updatesCoalesced = 0; // Overwritten before applied
+        std::uint64_t updatesApplied = 0;
+        std::uint64_t applyLatencyTotalUs = 0; // Receive to apply finished
+        std::uint64_t applyLatencyMaxUs = 0;
+    };
+
+    explicit VolumeApplier(ApplyFunction apply);
+    ~VolumeApplier();
+
+    void start();
+    void stop();
+
+    // Input side, lock-free and non-blocking
+    void frameReceived() {
+        m_framesReceived.fetch_add(1, std::memory_order_relaxed);
+    }
+    // receivedUs is when the value arrived (LatencyTracer::nowUs()); zero
+    // means now. A post without a mute state keeps the channel's last one,
+    // so it cannot replace a mute change that is still pending.
+    void post(int channel, int value, int mute = NO_MUTE,
+              std::uint64_t receivedUs = 0);
+
+    // Run the apply function soon even if no channel is pending, e.g. to
+    // pick up volume changes made by other programs; lock-free
+    void wake() {
+        if (!(m_pending.fetch_or(WAKE_BIT, std::memory_order_acq_rel) &
+              WAKE_BIT)) {
+            m_pending.notify_one();
+        }
+    }
+
+    Stats getStats() const;
+
+private:
+    // Bits of the pending mask used to wake the thread for shutdown and for
+    // wake()
+    static constexpr std::uint32_t STOP_BIT = 1u << 31;
+    static constexpr std::uint32_t WAKE_BIT = 1u << 30;
+    static_assert(MAX_CHANNELS <= 30, "Channel bits overlap the flags");
+
+    // Slot layout: value in bits 0-15, mute in bits 16-17 (bit 17 set when
+    // present), receive time in microseconds (truncated) in bits 32-63
+    static constexpr std::uint64_t SLOT_MUTE_BITS = 3ull << 16;
+    static std::uint64_t packSlot(int value, int mute, std::uint32_t timeUs);
+    static std::uint32_t nowUs();
+
+    void workerThread();
+
+    ApplyFunction m_apply;
+    std::array<std::atomic<std::uint64_t>, MAX_CHANNELS> m_slots{};
+    std::atomic<std::uint32_t> m_pending{0};
+
+    std::jthread m_workerThread;
+    std::atomic<bool> m_running{false};
+
+    // Statistics
+    std::atomic<std::uint64_t> m_framesReceived{0};
+    std::atomic<std::uint64_t> m_updatesPosted{0};
+    std::atomic<std::uint64_t> m_updatesCoalesced{0};
+    std::atomic<std::uint64_t> m_updatesApplied{0};
+    std::atomic<std::uint64_t> m_applyLatencyTotalUs{0};
+    std::atomic<std::uint64_t> m_applyLatencyMaxUs{0};
+
+    // Exported metrics, shared by all appliers
+    MetricCounter &m_coalescedMetric;
+    MetricCounter &m_appliedMetric;
+    MetricHistogram &m_latencyMetric;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * AppMatcher - Decides which volume target a process belongs to
+ *
+ * Targets are lowercase executable names or glob patterns, where '*'
+ * matches any run of characters and '?' any single one, each with a list of
+ * exclusion patterns. Plain names go into one hash table; globs are split
+ * once into their literal segments and kept ordered by how specific they
+ * are. A process matches its exact name first, then the glob with the most
+ * literal characters, skipping targets that exclude it, so "chrome*" wins
+ * over "*.exe". A process that matches nothing goes to the unmapped target,
+ * if there is one. Immutable once built.
+ */
+class AppMatcher {
+public:
+    using TargetId = std::uint32_t;
+    static constexpr TargetId NO_TARGET = ~TargetId{0};
+
+    struct TargetPatterns {
+        std::string pattern;                 // Lowercase name or glob
+        std::vector<std::string> exclusions; // Lowercase names or globs
+        bool unmapped = false; // Takes what no other target matches instead
+    };
+
+    AppMatcher() = default;
+    // Target i is targets[i]
+    explicit AppMatcher(std::span<const TargetPatterns> targets);
+
+    std::size_t targetCount() const { return m_targetCount; }
+
+    // Target of a process, or NO_TARGET; the name must be lowercase
+    TargetId match(std::string_view processNameLower) const;
+
+    // True if the pattern contains '*' or '?'
+    static bool isGlob(std::string_view pattern);
+
+private:
+    // Glob split at its '*'s; segments may contain '?'
+    struct Glob {
+        std::vector<std::string> segments;
+        std::size_t literalLength = 0; // Characters other than wildcards
+
+        explicit Glob(std::string_view pattern);
+        bool matches(std::string_view name) const;
+    };
+
+    struct GlobTarget {
+        Glob glob;
+        TargetId target;
+    };
+
+    bool isExcluded(TargetId target, std::string_view name) const;
+
+    std::size_t m_targetCount = 0;
+    TargetId m_unmappedTarget = NO_TARGET;
+    std::unordered_map<std::string, TargetId> m_exactTargets;
+    std::vector<GlobTarget> m_globTargets; // Most specific first
+    std::vector<std::vector<Glob>> m_exclusions; // By target ID
+};
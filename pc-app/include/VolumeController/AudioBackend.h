@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * AudioBackend - Platform audio API behind VolumeController
+ *
+ * A backend controls the master endpoint and the audio sessions of running
+ * applications. It reports sessions as they appear and disappear through a
+ * Listener, so VolumeController never has to enumerate sessions on the
+ * volume path, along with volume changes made by other programs. Listener
+ * calls may arrive on any thread.
+ */
+class AudioBackend {
+public:
+    using SessionId = std::uint64_t;
+
+    struct SessionInfo {
+        SessionId id;           // Unique for the lifetime of the backend
+        std::uint32_t processId;
+        std::string processName; // Executable name, e.g. "spotify.exe"
+    };
+
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+        virtual void onSessionAdded(const SessionInfo &session) = 0;
+        virtual void onSessionRemoved(SessionId sessionId) = 0;
+
+        // Another program has changed the volume or mute of a session or
+        // of the master endpoint. Backends must not report the echoes of
+        // their own set* calls: the controller takes any reported value
+        // that differs from what it wrote as a change made by another
+        // program, which detaches the knob.
+        virtual void onSessionVolumeChanged(SessionId, float, bool) {}
+        virtual void onMasterVolumeChanged(float, bool) {}
+    };
+
+    virtual ~AudioBackend() = default;
+
+    // Report every existing session to listener, then keep reporting
+    // changes until the backend is destroyed
+    virtual bool start(Listener &listener) = 0;
+
+    // Master endpoint
+    virtual bool setMasterVolume(float volumeLevel) = 0;
+    virtual bool setMasterMute(bool mute) = 0;
+
+    // Individual sessions
+    virtual bool setSessionVolume(SessionId sessionId, float volumeLevel) = 0;
+    virtual bool setSessionMute(SessionId sessionId, bool mute) = 0;
+};
+
+// Backend for the platform the application was built for
+std::unique_ptr<AudioBackend> createDefaultAudioBackend();
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Metrics.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * ProcessNameCache - Bounded cache of executable names by process
+ *
+ * Entries are keyed by process ID and process start time, so a PID that the
+ * system has handed to a new process never returns the old name, and no
+ * entry needs to expire by age. The cache holds at most capacity entries
+ * and, when full, evicts the oldest entry not hit since the last eviction
+ * pass (second chance, close to least recently used); entries of processes
+ * that have exited are pushed out that way. Safe to use from several
+ * threads: lookups share the lock and only mark the entry they hit, so
+ * they run in parallel. Hits, misses and evictions are also exported as
+ * metrics, summed over all caches.
+ *
+ * resolve() queries the operating system for the start time and, on a
+ * miss, the name: the process image on Windows, /proc/<pid> on Linux.
+ * find() and insert() serve callers that obtain both some other way.
+ */
+class ProcessNameCache {
+public:
+    using ProcessId = std::uint32_t;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::size_t size; // Entries currently cached
+    };
+
+    explicit ProcessNameCache(std::size_t capacity = DEFAULT_CAPACITY);
+
+    // Prevent copying and moving, the lock and counters stay in place
+    ProcessNameCache(const ProcessNameCache &) = delete;
+    ProcessNameCache &operator=(const ProcessNameCache &) = delete;
+
+    // Name of a running process, e.g. "spotify.exe", or "<unknown>" if the
+    // process is gone or not accessible. Failures are not cached.
+    std::string resolve(ProcessId processId);
+
+    // Cached name of the process instance; false on a miss
+    bool find(ProcessId processId, std::uint64_t startTime,
+              std::string &name);
+
+    // Remember a name, evicting an entry not used recently when full
+    void insert(ProcessId processId, std::uint64_t startTime,
+                std::string name);
+
+    Stats getStats() const;
+
+private:
+    struct Key {
+        ProcessId processId;
+        std::uint64_t startTime;
+
+        bool operator==(const Key &) const = default;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key &key) const {
+            // Start times are unique per PID, mixing them in is enough
+            return std::hash<std::uint64_t>{}(
+                key.startTime * 0x9E3779B97F4A7C15ull ^ key.processId);
+        }
+    };
+
+    struct Entry {
+        Entry(const Key &key, std::string name)
+            : key(key), name(std::move(name)) {}
+
+        Key key;
+        std::string name;
+        std::atomic<bool> referenced{false}; // Hit since last passed over
+    };
+
+    // Newest or last spared first; the map points into the list
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+    std::size_t m_capacity;
+    mutable std::shared_mutex m_mtx;
+
+    std::atomic<std::uint64_t> m_hits{0};
+    std::atomic<std::uint64_t> m_misses{0};
+    std::atomic<std::uint64_t> m_evictions{0};
+
+    MetricCounter &m_hitMetric;
+    MetricCounter &m_missMetric;
+    MetricCounter &m_evictionMetric;
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "AudioBackend.h"
+#include "ProcessNameCache.h"
+
+#include <pulse/pulseaudio.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * PulseAudioBackend - AudioBackend built on the libpulse asynchronous API
+ *
+ * Works with PulseAudio and with PipeWire through pipewire-pulse. Sessions
+ * are sink-inputs, named by their application.process.binary property or,
+ * for clients that do not set it, by their process, and the master channel
+ * is the default sink. Sink-inputs are listed once at
+ * start and then tracked through subscription events, which also report
+ * volume changes made by other programs; volume and mute changes are sent
+ * without waiting for the server to acknowledge them. The server reports
+ * our own changes too, without telling them apart, so values written in
+ * the last WRITE_ECHO_MS are recognised as echoes and not reported.
+ */
+class PulseAudioBackend : public AudioBackend {
+public:
+    PulseAudioBackend();
+    ~PulseAudioBackend() override;
+
+    bool start(Listener &listener) override;
+
+    bool setMasterVolume(float volumeLevel) override;
+    bool setMasterMute(bool mute) override;
+    bool setSessionVolume(SessionId sessionId, float volumeLevel) override;
+    bool setSessionMute(SessionId sessionId, bool mute) override;
+
+private:
+    // libpulse callbacks, invoked on the mainloop thread
+    static void contextStateCallback(pa_context *context, void *userdata);
+    static void subscribeCallback(pa_context *context,
+                                  pa_subscription_event_type_t type,
+                                  uint32_t index, void *userdata);
+    static void sinkInputInfoCallback(pa_context *context,
+                                      const pa_sink_input_info *info, int eol,
+                                      void *userdata);
+    static void sinkInfoCallback(pa_context *context, const pa_sink_info *info,
+                                 int eol, void *userdata);
+
+    // Block on an operation; the mainloop lock must be held
+    bool waitForOperation(pa_operation *operation);
+
+    // Ask the server for the default sink's channel count and volume
+    void queryDefaultSink();
+
+    // How long a written value is expected to come back as an echo
+    static constexpr int WRITE_ECHO_MS = 500;
+
+    // State of a sink-input or sink as last reported by the server, and
+    // the values we have written to it recently
+    class EndpointState {
+    public:
+        void recordVolume(pa_volume_t volume);
+        void recordMute(bool mute);
+
+        // Take over a reported state; true if it differs from the last one
+        // other than by values we have written
+        bool update(const pa_cvolume &volume, bool mute);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Write {
+            pa_volume_t volume = PA_VOLUME_INVALID; // Unset for mute writes
+            int mute = -1;                          // Unset for volume writes
+            Clock::time_point time;
+        };
+
+        bool isRecentWrite(pa_volume_t volume, int mute,
+                           Clock::time_point now) const;
+
+        pa_volume_t m_volume = PA_VOLUME_INVALID;
+        int m_mute = -1;
+        std::array<Write, 16> m_writes; // Ring, oldest overwritten first
+        std::size_t m_nextWrite = 0;
+    };
+
+    struct SinkInput {
+        uint8_t channels;
+        EndpointState state;
+    };
+
+    pa_threaded_mainloop *m_mainloop = nullptr;
+    pa_context *m_context = nullptr;
+
+    // Sink-input cache, maintained from subscription events; only touched
+    // with the mainloop lock held
+    Listener *m_listener = nullptr;
+    std::unordered_map<uint32_t, SinkInput> m_sinkInputs;
+    uint32_t m_sinkIndex = PA_INVALID_INDEX;
+    uint8_t m_sinkChannels = 1;
+    EndpointState m_sinkState;
+
+    // Names of clients without a process binary property
+    ProcessNameCache m_processNames;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * SessionIndex - Lookup table from process name to audio sessions
+ *
+ * Keeps the audio sessions of every process grouped by lowercased process
+ * name, so resolving the sessions of an application is a single hash
+ * lookup. The owner feeds it session-created and session-expired events;
+ * the index itself is platform-neutral and stores an opaque handle per
+ * session. Not thread-safe.
+ */
+template <typename Handle> class SessionIndex {
+public:
+    using SessionId = std::uint64_t;
+
+    struct Entry {
+        SessionId id;
+        Handle handle;
+    };
+
+    // Add a session; a session that is already known is replaced
+    void add(SessionId id, std::string_view processName, Handle handle) {
+        remove(id);
+        std::string name = toLower(processName);
+        m_byName[name].push_back({id, std::move(handle)});
+        m_names.emplace(id, std::move(name));
+    }
+
+    // Remove a session, returns false when it was not indexed
+    bool remove(SessionId id) {
+        auto nameIt = m_names.find(id);
+        if (nameIt == m_names.end()) {
+            return false;
+        }
+
+        auto it = m_byName.find(nameIt->second);
+        if (it != m_byName.end()) {
+            std::erase_if(it->second,
+                          [id](const Entry &entry) { return entry.id == id; });
+            if (it->second.empty()) {
+                m_byName.erase(it);
+            }
+        }
+        m_names.erase(nameIt);
+        return true;
+    }
+
+    // Sessions of a process; the name must already be lowercase. The view
+    // is invalidated by add() and remove().
+    std::span<const Entry> find(std::string_view processNameLower) const {
+        auto it = m_byName.find(processNameLower);
+        if (it == m_byName.end()) {
+            return {};
+        }
+        return it->second;
+    }
+
+    bool contains(SessionId id) const { return m_names.contains(id); }
+    std::size_t size() const { return m_names.size(); }
+
+    void clear() {
+        m_byName.clear();
+        m_names.clear();
+    }
+
+    static std::string toLower(std::string_view name) {
+        std::string lower(name);
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        return lower;
+    }
+
+private:
+    // Transparent hash so lookups by string_view do not allocate
+    struct NameHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    std::unordered_map<std::string, std::vector<Entry>, NameHash,
+                       std::equal_to<>>
+        m_byName;
+    std::unordered_map<SessionId, std::string> m_names;
+};
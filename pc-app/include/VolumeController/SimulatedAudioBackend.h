@@ -0,0 +1,90 @@
+#pragma once
+#include "AudioBackend.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * SimulatedAudioBackend - In-process AudioBackend without an audio system
+ *
+ * Models the master endpoint and a set of application sessions with their
+ * process IDs, applies a configurable latency to every backend call and
+ * counts the calls it receives. Used to run and measure the volume path on
+ * machines without a supported audio API. Like the platform backends, it
+ * does not report its own set* calls to the listener; only the change*()
+ * calls, standing in for other programs, are reported.
+ */
+class SimulatedAudioBackend : public AudioBackend {
+public:
+    struct SessionState {
+        std::uint32_t processId;
+        std::string processName;
+        float volume = 1.0f;
+        bool mute = false;
+    };
+
+    struct CallCounts {
+        std::uint64_t masterVolume = 0;
+        std::uint64_t masterMute = 0;
+        std::uint64_t sessionVolume = 0;
+        std::uint64_t sessionMute = 0;
+
+        std::uint64_t total() const {
+            return masterVolume + masterMute + sessionVolume + sessionMute;
+        }
+    };
+
+    SimulatedAudioBackend() = default;
+    explicit SimulatedAudioBackend(std::chrono::microseconds callLatency)
+        : m_callLatency(callLatency) {}
+
+    // AudioBackend
+    bool start(Listener &listener) override;
+    bool setMasterVolume(float volumeLevel) override;
+    bool setMasterMute(bool mute) override;
+    bool setSessionVolume(SessionId sessionId, float volumeLevel) override;
+    bool setSessionMute(SessionId sessionId, bool mute) override;
+
+    // Simulated audio system
+    SessionId addSession(std::uint32_t processId,
+                         const std::string &processName);
+    bool removeSession(SessionId sessionId);
+    // Change volumes as another program would, reported to the listener
+    bool changeSessionVolume(SessionId sessionId, float volumeLevel,
+                             bool mute);
+    void changeMasterVolume(float volumeLevel, bool mute);
+    void setCallLatency(std::chrono::microseconds callLatency) {
+        m_callLatency = callLatency;
+    }
+
+    // Inspection
+    float getMasterVolume() const;
+    bool getMasterMute() const;
+    std::optional<SessionState> getSession(SessionId sessionId) const;
+    CallCounts getCallCounts() const;
+    void resetCallCounts();
+
+private:
+    // Block for the configured call latency
+    void simulateLatency() const;
+
+    std::atomic<std::chrono::microseconds> m_callLatency{
+        std::chrono::microseconds(0)};
+
+    mutable std::mutex m_mutex;
+    Listener *m_listener = nullptr;
+    std::unordered_map<SessionId, SessionState> m_sessions;
+    SessionId m_nextSessionId = 1;
+    float m_masterVolume = 1.0f;
+    bool m_masterMute = false;
+
+    std::atomic<std::uint64_t> m_masterVolumeCalls{0};
+    std::atomic<std::uint64_t> m_masterMuteCalls{0};
+    std::atomic<std::uint64_t> m_sessionVolumeCalls{0};
+    std::atomic<std::uint64_t> m_sessionMuteCalls{0};
+};
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+class AppMatcher;
+class AudioBackend;
+
 /**
  * VolumeController - Controls system and application audio volumes
  *
@@ -13,7 +19,43 @@
  */
 class VolumeController {
 public:
+    static constexpr int NO_MUTE = -1;
+
+    // Target of the AppMatcher registered with setTargets()
+    using TargetId = std::uint32_t;
+
+    // One channel of a frame: the volume, and optionally the mute state, of
+    // a group of targets and, if master is set, of the master endpoint
+    struct ChannelUpdate {
+        std::span<const TargetId> targets;
+        bool master;
+        float volumeLevel;
+        int mute = NO_MUTE;
+        bool setVolume = true; // False to apply only the mute state
+    };
+
+    // A volume or mute change made by another program to a session of a
+    // target, or to the master endpoint if master is set
+    struct ExternalChange {
+        TargetId target;
+        bool master;
+        float volumeLevel;
+        bool mute;
+    };
+    using ExternalChangeCallback =
+        std::function<void(const ExternalChange &)>;
+
+    // Backend writes made and avoided by the value cache
+    struct Stats {
+        std::uint64_t backendWrites;   // Volume and mute calls made
+        std::uint64_t writesSkipped;   // Calls saved, value was unchanged
+        std::uint64_t externalChanges; // Changes made by other programs
+    };
+
+    // Uses the audio backend of the current platform
     VolumeController();
+    // Uses the given backend, e.g. a SimulatedAudioBackend
+    explicit VolumeController(std::unique_ptr<AudioBackend> backend);
     ~VolumeController();
 
     // Prevent copying, allow moving
@@ -33,6 +75,29 @@ public:
     bool setMute(const std::string &processName, int mute);
     bool setMute(const std::vector<std::string> &processNames, int mute);
 
+    // Set the targets that frames refer to. Every session is matched once,
+    // as it appears, and listed under its target, so applyFrame() does no
+    // name lookups.
+    void setTargets(const AppMatcher &matcher);
+
+    // Apply every channel of a frame under a single lock, resolving each
+    // target once for both volume and mute. Continues past failures and
+    // returns false if any backend call failed.
+    bool applyFrame(std::span<const ChannelUpdate> updates);
+
+    // Changes made by other programs are reported to callback from within
+    // applyFrame() and setTargets(), on the calling thread and with the
+    // controller locked. notify is called on a backend thread as soon as
+    // such a change may have happened, or a session has appeared, so the
+    // applying thread can call applyFrame(), with an empty frame if need
+    // be, to pick it up. Neither may call into the controller. Replacing
+    // them waits for a running call to return, so passing empty callbacks
+    // detaches them before what they refer to is destroyed.
+    void setExternalChangeCallbacks(ExternalChangeCallback callback,
+                                    std::function<void()> notify);
+
+    Stats getStats() const;
+
 private:
     // Forward declaration of implementation class
     class Impl;
@@ -0,0 +1,166 @@
+#pragma once
+#include "AppMatcher.h"
+#include "AudioBackend.h"
+#include "Metrics.h"
+#include "SessionIndex.h"
+#include "VolumeController.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Platform-independent implementation of VolumeController
+ *
+ * Resolves process names to audio sessions through a SessionIndex that is
+ * kept current by the backend's session notifications, and forwards the
+ * resulting volume and mute changes to the AudioBackend. Sessions whose
+ * process matches a registered target are also listed under that target,
+ * which is all applyFrame() looks at. The last value
+ * written to each session and to the master endpoint is cached, so values
+ * that did not change are not written again until the session is new or
+ * another program has changed it. Such changes to targets and to the
+ * master endpoint are passed on to the external change callback. The last
+ * frame value of each target is kept as well, so a session that appears
+ * later starts out at its channel's volume.
+ */
+class VolumeController::Impl : private AudioBackend::Listener {
+public:
+    explicit Impl(std::unique_ptr<AudioBackend> audioBackend);
+    ~Impl();
+
+    // Volume control methods
+    bool setMasterVolume(float volumeLevel);
+    bool setVolume(const std::string &processName, float volumeLevel);
+    bool setVolume(const std::vector<std::string> &processNames,
+                   float volumeLevel);
+
+    // Mute control methods
+    bool setMasterMute(int mute);
+    bool setMute(const std::string &processName, int mute);
+    bool setMute(const std::vector<std::string> &processNames, int mute);
+
+    // Batch control
+    void setTargets(const AppMatcher &matcher);
+    bool applyFrame(std::span<const ChannelUpdate> updates);
+    void setExternalChangeCallbacks(ExternalChangeCallback callback,
+                                    std::function<void()> notify);
+
+    Stats getStats() const;
+
+private:
+    // Internal implementation methods (thread-unsafe)
+    bool setVolumeInternal(const std::string &processName, float volumeLevel);
+    bool setMuteInternal(const std::string &processName, int mute);
+
+    // Backend writes through the value cache (thread-unsafe)
+    bool writeMasterVolume(float volumeLevel);
+    bool writeMasterMute(int mute);
+    template <typename Write>
+    bool writeIfChanged(int &appliedValue, int value, Write write);
+
+    // AudioBackend::Listener, called from backend threads
+    void onSessionAdded(const AudioBackend::SessionInfo &session) override;
+    void onSessionRemoved(AudioBackend::SessionId sessionId) override;
+    void onSessionVolumeChanged(AudioBackend::SessionId sessionId,
+                                float volumeLevel, bool mute) override;
+    void onMasterVolumeChanged(float volumeLevel, bool mute) override;
+
+    // Apply queued session notifications to the index (thread-unsafe)
+    void processSessionEvents();
+
+    enum class EventType { Added, Removed, VolumeChanged, MasterChanged };
+
+    struct SessionEvent {
+        EventType type;
+        AudioBackend::SessionInfo session;
+        float volumeLevel = 0.0f;
+        bool mute = false;
+    };
+
+    // Values as last written to an endpoint; volumes are quantized to the
+    // resolution of the device so float noise does not count as a change
+    static constexpr int VOLUME_STEPS = 1024;
+    static constexpr int UNKNOWN = -1;
+
+    struct AppliedState {
+        int volume = UNKNOWN;
+        int mute = UNKNOWN;
+    };
+
+    static int quantizeVolume(float volumeLevel);
+
+    // Take over values that another program has set; true if they differ
+    // from what was written last (thread-unsafe)
+    bool checkAppliedState(AppliedState &state, float volumeLevel, bool mute);
+
+    static constexpr TargetId NO_TARGET = AppMatcher::NO_TARGET;
+
+    struct Session {
+        AudioBackend::SessionId id;
+        std::string processNameLower;
+        TargetId target = NO_TARGET;
+        AppliedState applied; // Fresh for every new session
+    };
+
+    // Add or remove a session in the list of its target (thread-unsafe)
+    void assignTarget(Session &session);
+    void unassignTarget(Session &session);
+
+    // Session writes through the value cache (thread-unsafe)
+    bool writeSessionVolume(Session &session, float volumeLevel);
+    bool writeSessionMute(Session &session, int mute);
+
+    // Known sessions; the map's nodes keep the pointers below valid
+    std::unordered_map<AudioBackend::SessionId, Session> sessions;
+
+    // Sessions by process name
+    SessionIndex<Session *> sessionIndex;
+
+    // Sessions by target ID, and the matcher that assigns them
+    std::vector<std::vector<Session *>> targetSessions;
+    AppMatcher targetMatcher;
+
+    // Last frame values by target ID, for sessions that appear later
+    struct TargetState {
+        bool known = false;
+        float volumeLevel = 0.0f;
+        int mute = NO_MUTE;
+    };
+    std::vector<TargetState> targetStates;
+
+    // Sessions added by the event batch being processed
+    std::vector<Session *> addedSessions;
+
+    // Write cache of the master endpoint
+    AppliedState masterState;
+
+    // Receives changes made by other programs
+    ExternalChangeCallback externalChangeCallback;
+
+    // Write statistics
+    std::atomic<std::uint64_t> backendWrites{0};
+    std::atomic<std::uint64_t> writesSkipped{0};
+    std::atomic<std::uint64_t> externalChanges{0};
+
+    // Exported metrics, shared by all controllers
+    MetricHistogram &backendCallMetric;
+    MetricCounter &backendFailureMetric;
+    MetricCounter &writesSkippedMetric;
+    MetricCounter &externalChangeMetric;
+
+    // Session notifications waiting to be applied
+    std::mutex eventMtx;
+    std::atomic<bool> eventsPending{false};
+    std::vector<SessionEvent> pendingEvents;
+    std::vector<SessionEvent> processingEvents;
+    std::function<void()> notifyExternalChange; // Guarded by eventMtx
+
+    std::unique_ptr<AudioBackend> backend;
+
+    // Thread safety
+    std::mutex mtx;
+};
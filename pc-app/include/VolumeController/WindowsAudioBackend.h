@@ -0,0 +1,87 @@
+#pragma once
+#include "AudioBackend.h"
+#include "ProcessNameCache.h"
+
+#include <atlbase.h>
+#include <audiopolicy.h>
+#include <endpointvolume.h>
+#include <mmdeviceapi.h>
+#include <windows.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Link between the COM event sinks and their backend, defined in the source
+struct AudioSessionSinkTarget;
+
+/**
+ * WindowsAudioBackend - AudioBackend built on WASAPI
+ *
+ * Controls the default render endpoint and the audio sessions on it.
+ * Sessions are tracked through IAudioSessionNotification and per-session
+ * IAudioSessionEvents, so they are enumerated only once at start. Our own
+ * volume changes carry an event context that keeps them out of the volume
+ * notifications.
+ */
+class WindowsAudioBackend : public AudioBackend {
+public:
+    WindowsAudioBackend();
+    ~WindowsAudioBackend() override;
+
+    bool start(Listener &listener) override;
+
+    bool setMasterVolume(float volumeLevel) override;
+    bool setMasterMute(bool mute) override;
+    bool setSessionVolume(SessionId sessionId, float volumeLevel) override;
+    bool setSessionMute(SessionId sessionId, bool mute) override;
+
+    // Called by the COM event sinks, possibly on COM worker threads
+    void handleSessionCreated(IAudioSessionControl *sessionControl);
+    void handleSessionExpired(SessionId sessionId);
+    void handleVolumeChanged(SessionId sessionId, float volumeLevel,
+                             bool mute);
+    void handleMasterVolumeChanged(float volumeLevel, bool mute);
+
+private:
+    // Windows COM initialization
+    bool initializeCOM();
+
+    // Session tracking (thread-unsafe)
+    void addSession(IAudioSessionControl *sessionControl);
+    CComPtr<ISimpleAudioVolume> findSession(SessionId sessionId);
+    void releaseRetiredSessions();
+    void releaseSessions();
+
+    struct Session {
+        CComPtr<IAudioSessionControl> control;
+        CComPtr<ISimpleAudioVolume> volume;
+        CComPtr<IAudioSessionEvents> events;
+        std::wstring instanceId;
+    };
+
+    // Windows COM interfaces
+    CComPtr<IMMDeviceEnumerator> pEnumerator;
+    CComPtr<IMMDevice> pDevice;
+    CComPtr<IAudioEndpointVolume> pEndpointVolume;
+    CComPtr<IAudioSessionManager2> pSessionManager;
+    CComPtr<IAudioSessionNotification> sessionNotifier;
+    CComPtr<IAudioEndpointVolumeCallback> endpointEvents;
+    std::shared_ptr<AudioSessionSinkTarget> sinkTarget;
+
+    // Known sessions; expired ones are retired first because their event
+    // sink may not be unregistered from inside its own callback
+    std::unordered_map<SessionId, Session> sessions;
+    std::unordered_map<std::wstring, SessionId> sessionInstanceIds;
+    std::vector<Session> retiredSessions;
+    SessionId nextSessionId = 1;
+    Listener *listener = nullptr;
+
+    // Executable names of the processes behind sessions
+    ProcessNameCache processNames;
+
+    // Thread safety
+    std::mutex mtx;
+};
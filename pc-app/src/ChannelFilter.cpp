@@ -0,0 +1,95 @@
+#include "ChannelFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numbers>
+
+namespace {
+
+// Shortest step assumed between two values, for values sent back to back
+constexpr double MIN_DT_SECONDS = 1e-4;
+
+// Smoothing factor of a first-order low-pass filter
+double lowPassAlpha(double cutoffHz, double dtSeconds) {
+    double tau = 1.0 / (2.0 * std::numbers::pi * cutoffHz);
+    return 1.0 / (1.0 + tau / dtSeconds);
+}
+
+// Snap both ends to the limits and stretch the rest over the full range
+int applyDeadzone(int value, int deadzone) {
+    constexpr int maxValue = ChannelFilter::MAX_VALUE;
+    if (deadzone <= 0) {
+        return value;
+    }
+    if (value <= deadzone) {
+        return 0;
+    }
+    if (value >= maxValue - deadzone) {
+        return maxValue;
+    }
+    return static_cast<int>(std::lround((value - deadzone) *
+                                        static_cast<double>(maxValue) /
+                                        (maxValue - 2 * deadzone)));
+}
+
+} // namespace
+
+double ChannelFilter::smooth(double value, double dtSeconds,
+                             const FilterSettings &settings) {
+    switch (settings.mode) {
+    case FilterMode::None:
+        m_value = value;
+        break;
+    case FilterMode::Ema:
+        m_value += (1.0 - std::exp(-dtSeconds * 1000.0 /
+                                   std::max(settings.timeConstantMs, 1e-3))) *
+                   (value - m_value);
+        break;
+    case FilterMode::OneEuro: {
+        // Raise the cutoff with the knob's speed, itself low-pass filtered
+        double speed = (value - m_value) / dtSeconds;
+        m_derivative +=
+            lowPassAlpha(settings.derivativeCutoffHz, dtSeconds) *
+            (speed - m_derivative);
+        double cutoffHz =
+            settings.minCutoffHz + settings.beta * std::abs(m_derivative);
+        m_value += lowPassAlpha(cutoffHz, dtSeconds) * (value - m_value);
+        break;
+    }
+    }
+    return m_value;
+}
+
+std::optional<int> ChannelFilter::process(int value, std::uint64_t timeUs,
+                                          const FilterSettings &settings) {
+    value = std::clamp(value, 0, MAX_VALUE);
+
+    double filtered = value;
+    if (!m_started) {
+        m_started = true;
+        m_value = value;
+        m_derivative = 0.0;
+    } else {
+        double dtSeconds =
+            timeUs > m_lastTimeUs ? (timeUs - m_lastTimeUs) / 1e6 : 0.0;
+        filtered =
+            smooth(value, std::max(dtSeconds, MIN_DT_SECONDS), settings);
+    }
+    m_lastTimeUs = timeUs;
+
+    int output = applyDeadzone(static_cast<int>(std::lround(filtered)),
+                               settings.deadzone);
+
+    // Small changes are jitter, except on the way to either end so the
+    // knob can always reach silence and full volume
+    if (m_output >= 0) {
+        bool atEnd = output == 0 || output == MAX_VALUE;
+        if (output == m_output ||
+            (!atEnd && std::abs(output - m_output) < settings.hysteresis)) {
+            return std::nullopt;
+        }
+    }
+    m_output = output;
+    return output;
+}
@@ -0,0 +1,66 @@
+#include "ChannelSync.h"
+
+#include "VolwareProtocol.h"
+
+#include <cstdlib>
+
+namespace {
+
+bool nearby(int a, int b) {
+    return std::abs(a - b) < volware::protocol::PICKUP_THRESHOLD;
+}
+
+} // namespace
+
+ChannelSync::Decision ChannelSync::deviceUpdate(int channel, int value,
+                                                int mute) {
+    Decision decision{true, mute >= 0};
+    if (channel < 0 || channel >= MAX_CHANNELS) {
+        return decision;
+    }
+    Channel &state = m_channels[channel];
+
+    // Repeats of the position the knob had when it was detached are
+    // dropped; anything further away means it was turned
+    if (state.volumeDetached && nearby(value, state.knobValue)) {
+        decision.volume = false;
+    } else {
+        state.volumeDetached = false;
+        state.knobValue = value;
+    }
+
+    // A mute state different from the last one reported is a button press
+    if (mute >= 0) {
+        if (state.muteDetached && mute == state.knobMute) {
+            decision.mute = false;
+        } else {
+            state.muteDetached = false;
+        }
+        state.knobMute = mute;
+    }
+    return decision;
+}
+
+void ChannelSync::externalChange(int channel, int value, bool mute) {
+    if (channel < 0 || channel >= MAX_CHANNELS) {
+        return;
+    }
+    Channel &state = m_channels[channel];
+
+    // Before the first frame from the device there is no knob to detach
+    if (state.knobValue >= 0 && !nearby(value, state.knobValue)) {
+        state.volumeDetached = true;
+    }
+    if (state.knobMute >= 0 && static_cast<int>(mute) != state.knobMute) {
+        state.muteDetached = true;
+    }
+    state.hostValue = value;
+    state.hostMute = mute;
+    m_hostChanges |= 1u << channel;
+}
+
+std::uint32_t ChannelSync::takeHostChanges() {
+    std::uint32_t changes = m_hostChanges;
+    m_hostChanges = 0;
+    return changes;
+}
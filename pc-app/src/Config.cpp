@@ -1,4 +1,5 @@
 #include "Config.h"
+#include <algorithm>
 #include <filesystem>
 
 Config::Config() : m_configFilePath("config.yaml") { loadConfig(); }
@@ -8,25 +9,60 @@ Config::Config(const std::string &configFilePath)
     loadConfig();
 }
 
+void Config::keepDevices(const Config &previous) {
+    m_devices = previous.m_devices;
+    m_channelApps = previous.m_channelApps;
+    m_dispatchTable = previous.m_dispatchTable;
+}
+
 void Config::loadConfig() {
     try {
         // Find config file in current working directory
         auto yamlPath = std::filesystem::current_path() / m_configFilePath;
         YAML::Node config = YAML::LoadFile(yamlPath.string());
 
-        // Parse required configuration fields
-        if (config["com_port"]) {
-            m_comPort = config["com_port"].as<std::string>();
+        // Mute buttons, the default of every device
+        int muteButtonCount = 0;
+        if (config["mute_buttons"]) {
+            muteButtonCount = parseMuteButtons(config["mute_buttons"]);
+            m_muteButtons = muteButtonCount != 0;
         } else {
-            throw std::runtime_error("Missing 'com_port' in config file.");
+            throw std::runtime_error("Missing 'mute_buttons' in config file.");
         }
 
-        if (config["baud_rate"]) {
-            m_baudRate = config["baud_rate"].as<int>();
+        // Parse the devices: a 'devices' list, or a single device from the
+        // top-level com_port, baud_rate and channel_apps
+        if (config["devices"]) {
+            for (const auto &device : config["devices"]) {
+                m_devices.push_back(parseDevice(device, muteButtonCount));
+            }
+            if (m_devices.empty()) {
+                throw std::runtime_error("'devices' in config file is empty.");
+            }
         } else {
-            throw std::runtime_error("Missing 'baud_rate' in config file.");
+            m_devices.push_back(parseDevice(config, muteButtonCount));
         }
 
+        // Lay the devices' channels out one after another
+        int channelOffset = 0;
+        for (DeviceConfig &device : m_devices) {
+            device.channelOffset = channelOffset;
+            for (const auto &[channel, apps] : device.channelApps) {
+                m_channelApps[channelOffset + channel] = apps;
+            }
+            channelOffset += device.channelCount;
+        }
+        if (channelOffset > MAX_GLOBAL_CHANNELS) {
+            throw std::runtime_error(
+                "The devices use " + std::to_string(channelOffset) +
+                " channels, at most " + std::to_string(MAX_GLOBAL_CHANNELS) +
+                " are supported.");
+        }
+
+        // Resolve the application names once, not on every frame
+        m_dispatchTable = DispatchTable(m_channelApps);
+
+        // Parse required configuration fields
         if (config["invert_slider"]) {
             m_invertSlider = config["invert_slider"].as<bool>();
         } else {
@@ -39,23 +75,33 @@ void Config::loadConfig() {
             throw std::runtime_error("Missing 'auto_start' in config file.");
         }
 
-        if (config["mute_buttons"]) {
-            m_muteButtons = config["mute_buttons"].as<bool>();
-        } else {
-            throw std::runtime_error("Missing 'mute_buttons' in config file.");
+        // Optional fields
+        if (config["binary_protocol"]) {
+            m_binaryProtocol = config["binary_protocol"].as<bool>();
         }
 
-        // Parse channel to applications mapping
-        if (config["channel_apps"]) {
-            for (const auto &channel : config["channel_apps"]) {
-                int channelNumber = channel.first.as<int>();
-                std::vector<std::string> apps =
-                    channel.second.as<std::vector<std::string>>();
-                m_channelApps[channelNumber] = apps;
+        if (config["latency_trace"]) {
+            const YAML::Node &trace = config["latency_trace"];
+            if (trace["log_interval_ms"]) {
+                m_latencyLogIntervalMs =
+                    trace["log_interval_ms"].as<unsigned int>();
             }
-        } else {
-            throw std::runtime_error("Missing 'channel_apps' in config file.");
+            if (trace["chrome_trace_file"]) {
+                m_latencyTraceFile =
+                    trace["chrome_trace_file"].as<std::string>();
+            }
+        }
+
+        if (config["metrics"] && config["metrics"]["port"]) {
+            m_metricsPort = config["metrics"]["port"].as<unsigned short>();
+        }
+
+        // Optional knob value processing
+        CurveSettings curve;
+        if (config["signal"]) {
+            parseSignal(config["signal"], curve);
         }
+        m_responseCurve = ResponseCurve(curve, m_invertSlider);
     } catch (const YAML::Exception &e) {
         throw std::runtime_error("YAML parsing error: " +
                                  std::string(e.what()));
@@ -64,3 +110,117 @@ void Config::loadConfig() {
                                  std::string(e.what()));
     }
 }
+
+DeviceConfig Config::parseDevice(const YAML::Node &node,
+                                 int muteButtonCount) {
+    DeviceConfig device;
+    device.muteButtonCount = node["mute_buttons"]
+                                 ? parseMuteButtons(node["mute_buttons"])
+                                 : muteButtonCount;
+
+    if (node["com_port"]) {
+        device.comPort = node["com_port"].as<std::string>();
+    } else {
+        throw std::runtime_error("Missing 'com_port' in config file.");
+    }
+
+    if (node["baud_rate"]) {
+        device.baudRate = node["baud_rate"].as<int>();
+    } else {
+        throw std::runtime_error("Missing 'baud_rate' in config file.");
+    }
+
+    // Parse channel to applications mapping
+    if (node["channel_apps"]) {
+        for (const auto &channel : node["channel_apps"]) {
+            int channelNumber = channel.first.as<int>();
+            if (channelNumber < 0) {
+                throw std::runtime_error("Negative channel in 'channel_apps'.");
+            }
+            device.channelApps[channelNumber] =
+                channel.second.as<std::vector<std::string>>();
+            device.channelCount =
+                std::max(device.channelCount, channelNumber + 1);
+        }
+    } else {
+        throw std::runtime_error("Missing 'channel_apps' in config file.");
+    }
+    return device;
+}
+
+int Config::parseMuteButtons(const YAML::Node &node) {
+    // true for a mute button per knob, or the number of buttons of a
+    // board with fewer buttons than knobs
+    bool enabled;
+    if (YAML::convert<bool>::decode(node, enabled)) {
+        return enabled ? DeviceConfig::MUTE_PER_CHANNEL : 0;
+    }
+    int count = node.as<int>();
+    if (count < 0) {
+        throw std::runtime_error("Negative count in 'mute_buttons'.");
+    }
+    return count;
+}
+
+void Config::parseSignal(const YAML::Node &node, CurveSettings &curve) {
+    FilterSettings &filter = m_filterSettings;
+    if (node["filter"]) {
+        std::string mode = node["filter"].as<std::string>();
+        if (mode == "none") {
+            filter.mode = FilterMode::None;
+        } else if (mode == "ema") {
+            filter.mode = FilterMode::Ema;
+        } else if (mode == "one_euro") {
+            filter.mode = FilterMode::OneEuro;
+        } else {
+            throw std::runtime_error("Unknown 'filter' " + mode +
+                                     ", expected none, ema or one_euro.");
+        }
+    }
+    if (node["time_constant_ms"]) {
+        filter.timeConstantMs = node["time_constant_ms"].as<double>();
+    }
+    if (node["min_cutoff_hz"]) {
+        filter.minCutoffHz = node["min_cutoff_hz"].as<double>();
+    }
+    if (node["beta"]) {
+        filter.beta = node["beta"].as<double>();
+    }
+    if (node["hysteresis"]) {
+        filter.hysteresis = node["hysteresis"].as<int>();
+    }
+    if (node["deadzone"]) {
+        filter.deadzone = node["deadzone"].as<int>();
+        if (filter.deadzone < 0 ||
+            filter.deadzone * 2 >= ChannelFilter::MAX_VALUE) {
+            throw std::runtime_error("'deadzone' must be between 0 and 510.");
+        }
+    }
+    if (filter.timeConstantMs <= 0.0 || filter.minCutoffHz <= 0.0) {
+        throw std::runtime_error(
+            "'time_constant_ms' and 'min_cutoff_hz' must be positive.");
+    }
+
+    if (node["curve"]) {
+        std::string type = node["curve"].as<std::string>();
+        if (type == "linear") {
+            curve.type = CurveType::Linear;
+        } else if (type == "log") {
+            curve.type = CurveType::Logarithmic;
+        } else if (type == "table") {
+            curve.type = CurveType::Table;
+        } else {
+            throw std::runtime_error("Unknown 'curve' " + type +
+                                     ", expected linear, log or table.");
+        }
+    }
+    if (node["curve_range_db"]) {
+        curve.rangeDb = node["curve_range_db"].as<double>();
+    }
+    if (node["curve_points"]) {
+        curve.points = node["curve_points"].as<std::vector<double>>();
+    }
+    if (curve.type == CurveType::Table && curve.points.size() < 2) {
+        throw std::runtime_error("'curve_points' needs at least two points.");
+    }
+}
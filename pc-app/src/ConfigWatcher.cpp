@@ -0,0 +1,262 @@
+#include "ConfigWatcher.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <system_error>
+
+#if defined(__linux__)
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#endif
+
+namespace {
+
+/**
+ * Wakes up when a file in a directory may have changed, or at once when a
+ * stop is requested
+ */
+class FileWatch {
+public:
+    FileWatch(const std::filesystem::path &path, std::stop_token stopToken)
+        : m_path(path) {
+        m_lastWriteTime = lastWriteTime();
+#if defined(__linux__)
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd >= 0 &&
+            inotify_add_watch(m_fd, path.parent_path().c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close(m_fd);
+            m_fd = -1;
+        }
+        m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif defined(_WIN32) || defined(_WIN64)
+        m_change = FindFirstChangeNotificationW(
+            path.parent_path().c_str(), FALSE,
+            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        m_stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+#endif
+        m_stopCallback.emplace(std::move(stopToken), [this] { wake(); });
+    }
+
+    ~FileWatch() {
+        m_stopCallback.reset(); // Waits for a wake() in progress
+#if defined(__linux__)
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+        if (m_stopFd >= 0) {
+            close(m_stopFd);
+        }
+#elif defined(_WIN32) || defined(_WIN64)
+        if (m_change != INVALID_HANDLE_VALUE) {
+            FindCloseChangeNotification(m_change);
+        }
+        if (m_stopEvent != NULL) {
+            CloseHandle(m_stopEvent);
+        }
+#endif
+    }
+
+    FileWatch(const FileWatch &) = delete;
+    FileWatch &operator=(const FileWatch &) = delete;
+
+    // Without a directory watch, or a way to end a wait early, the file
+    // has to be polled
+    bool isPolling() const {
+#if defined(__linux__)
+        return m_fd < 0 || m_stopFd < 0;
+#elif defined(_WIN32) || defined(_WIN64)
+        return m_change == INVALID_HANDLE_VALUE || m_stopEvent == NULL;
+#else
+        return true;
+#endif
+    }
+
+    // Wait up to timeoutMs, or without a limit if it is negative; true if
+    // the file was written or replaced. Without a directory watch this
+    // falls back to comparing the file's modification time.
+    bool wait(int timeoutMs) {
+#if defined(__linux__)
+        pollfd fds[] = {{m_fd, POLLIN, 0}, {m_stopFd, POLLIN, 0}};
+        if (m_fd < 0) {
+            // Sleep until the timeout or a stop
+            poll(fds + 1, 1, timeoutMs);
+            return modified();
+        }
+        if (poll(fds, 2, timeoutMs) <= 0 || !(fds[0].revents & POLLIN)) {
+            return false;
+        }
+
+        // Only events naming our file count
+        alignas(inotify_event) char buffer[4096];
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + length;) {
+                auto *event = reinterpret_cast<inotify_event *>(p);
+                if (event->len > 0 && m_path.filename() == event->name) {
+                    changed = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+#elif defined(_WIN32) || defined(_WIN64)
+        DWORD timeout = timeoutMs < 0 ? INFINITE : timeoutMs;
+        HANDLE handles[2];
+        DWORD count = 0;
+        if (m_change != INVALID_HANDLE_VALUE) {
+            handles[count++] = m_change;
+        }
+        if (m_stopEvent != NULL) {
+            handles[count++] = m_stopEvent;
+        }
+        if (count == 0) {
+            Sleep(timeout);
+            return modified();
+        }
+
+        DWORD result = WaitForMultipleObjects(count, handles, FALSE, timeout);
+        if (m_change == INVALID_HANDLE_VALUE) {
+            return modified();
+        }
+        if (result != WAIT_OBJECT_0) {
+            return false;
+        }
+        FindNextChangeNotification(m_change);
+        return modified();
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        return modified();
+#endif
+    }
+
+private:
+    std::filesystem::file_time_type lastWriteTime() const {
+        std::error_code error;
+        return std::filesystem::last_write_time(m_path, error);
+    }
+
+    // Compare the modification time with the one seen last
+    bool modified() {
+        std::filesystem::file_time_type writeTime = lastWriteTime();
+        if (writeTime == m_lastWriteTime) {
+            return false;
+        }
+        m_lastWriteTime = writeTime;
+        return true;
+    }
+
+    // Make a current or the next wait() return
+    void wake() {
+#if defined(__linux__)
+        std::uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(m_stopFd, &one, sizeof(one));
+#elif defined(_WIN32) || defined(_WIN64)
+        SetEvent(m_stopEvent);
+#endif
+    }
+
+    std::filesystem::path m_path;
+    std::filesystem::file_time_type m_lastWriteTime;
+#if defined(__linux__)
+    int m_fd = -1;
+    int m_stopFd = -1;
+#elif defined(_WIN32) || defined(_WIN64)
+    HANDLE m_change = INVALID_HANDLE_VALUE;
+    HANDLE m_stopEvent = NULL;
+#endif
+    std::optional<std::stop_callback<std::function<void()>>> m_stopCallback;
+};
+
+} // namespace
+
+ConfigWatcher::ConfigWatcher(std::shared_ptr<const Config> config)
+    : m_path(std::filesystem::absolute(config->getConfigFilePath())),
+      m_config(std::move(config)) {}
+
+ConfigWatcher::~ConfigWatcher() { stop(); }
+
+bool ConfigWatcher::start() {
+    if (m_thread.joinable()) {
+        return true;
+    }
+    m_thread = std::jthread(
+        [this](std::stop_token stopToken) { watchThread(stopToken); });
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (m_thread.joinable()) {
+        m_thread.request_stop();
+        m_thread.join();
+    }
+}
+
+bool ConfigWatcher::reload() {
+    std::shared_ptr<Config> config;
+    try {
+        config = std::make_shared<Config>(m_path.string());
+    } catch (const std::exception &e) {
+        std::cerr << "Keeping previous configuration. " << e.what()
+                  << std::endl;
+        return false;
+    }
+
+    // The readers stay connected to the ports they were started with, and
+    // each reads its channels by its index in the device list, so a change
+    // of the devices keeps the previous ones with their channel mapping
+    std::shared_ptr<const Config> previousConfig = current();
+    const std::vector<DeviceConfig> &devices = config->getDevices();
+    const std::vector<DeviceConfig> &previous = previousConfig->getDevices();
+    bool devicesChanged = devices.size() != previous.size();
+    for (std::size_t i = 0; i < devices.size() && !devicesChanged; i++) {
+        devicesChanged = devices[i].comPort != previous[i].comPort ||
+                         devices[i].baudRate != previous[i].baudRate;
+    }
+    if (devicesChanged) {
+        config->keepDevices(*previousConfig);
+        std::cerr << "Device changes take effect after a restart; keeping "
+                     "the current devices and their channel_apps."
+                  << std::endl;
+    }
+
+    m_config.store(config, std::memory_order_release);
+    std::cout << "Configuration reloaded." << std::endl;
+    if (m_callback) {
+        m_callback(config);
+    }
+    return true;
+}
+
+void ConfigWatcher::watchThread(std::stop_token stopToken) {
+    FileWatch watch(m_path, stopToken);
+
+    // Reload once no change has been seen for SETTLE_DELAY_MS. With a
+    // directory watch the thread sleeps until something changes.
+    bool pending = false;
+    while (!stopToken.stop_requested()) {
+        int timeoutMs = pending            ? SETTLE_DELAY_MS
+                        : watch.isPolling() ? POLL_INTERVAL_MS
+                                            : -1;
+        bool changed = watch.wait(timeoutMs);
+
+        // A stop ends the wait early; never publish a config while stopping
+        if (stopToken.stop_requested()) {
+            break;
+        }
+        if (changed) {
+            pending = true;
+        } else if (pending) {
+            pending = false;
+            reload();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#include "DispatchTable.h"
+
+#include <algorithm>
+#include <cctype>
+
+DispatchTable::DispatchTable(
+    const std::unordered_map<int, std::vector<std::string>> &channelApps) {
+    int channelCount = 0;
+    for (const auto &[channel, apps] : channelApps) {
+        channelCount = std::max(channelCount, channel + 1);
+    }
+    m_channels.resize(channelCount);
+
+    // Walk the channels in order so each one's targets are contiguous
+    std::unordered_map<std::string, TargetId> internedNames;
+    std::vector<AppMatcher::TargetPatterns> targetPatterns;
+    for (int channelNumber = 0; channelNumber < channelCount;
+         channelNumber++) {
+        auto it = channelApps.find(channelNumber);
+        if (it == channelApps.end()) {
+            continue;
+        }
+
+        Channel &channel = m_channels[channelNumber];
+        channel.mapped = true;
+        channel.firstTarget = static_cast<std::uint32_t>(m_targetIds.size());
+
+        std::vector<std::string> exclusions;
+        for (const std::string &app : it->second) {
+            std::string name(app);
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return std::tolower(c); });
+
+            if (name == "master") {
+                channel.master = true;
+                continue;
+            }
+            if (name.starts_with('!')) {
+                if (name.size() > 1) {
+                    exclusions.push_back(name.substr(1));
+                }
+                continue;
+            }
+
+            auto [nameIt, added] = internedNames.try_emplace(
+                name, static_cast<TargetId>(targetPatterns.size()));
+            if (added) {
+                targetPatterns.push_back({name, {}, name == "unmapped"});
+            }
+
+            // A name listed twice for one channel is applied once
+            std::span<const TargetId> assigned = targets(channel);
+            if (std::find(assigned.begin(), assigned.end(), nameIt->second) ==
+                assigned.end()) {
+                m_targetIds.push_back(nameIt->second);
+                channel.targetCount++;
+            }
+        }
+
+        for (TargetId target : targets(channel)) {
+            std::vector<std::string> &targetExclusions =
+                targetPatterns[target].exclusions;
+            targetExclusions.insert(targetExclusions.end(), exclusions.begin(),
+                                    exclusions.end());
+        }
+    }
+
+    m_matcher = AppMatcher(targetPatterns);
+}
@@ -0,0 +1,143 @@
+#include "FrameDecoder.h"
+
+namespace protocol = volware::protocol;
+
+FrameDecoder::Result FrameDecoder::decode(std::string_view data) {
+    if (data.empty()) {
+        return {};
+    }
+
+    if (static_cast<std::uint8_t>(data.front()) == protocol::SYNC_BYTE) {
+        return decodeBinary(data);
+    }
+
+    if (m_binary) {
+        // Resynchronise on the next sync byte
+        std::size_t next = data.find(static_cast<char>(protocol::SYNC_BYTE));
+        std::size_t skipped = next == std::string_view::npos ? data.size()
+                                                             : next;
+        m_stats.discardedBytes += skipped;
+        return {skipped, false};
+    }
+
+    return decodeAscii(data);
+}
+
+FrameDecoder::Result FrameDecoder::decodeBinary(std::string_view data) {
+    if (data.size() < protocol::HEADER_SIZE) {
+        return {};
+    }
+
+    const auto *frame = reinterpret_cast<const std::uint8_t *>(data.data());
+    std::uint8_t size = protocol::frameSize(frame[1], frame[3]);
+    if (data.size() < size) {
+        return {};
+    }
+
+    std::uint8_t type = frame[1] & protocol::FRAME_TYPE_MASK;
+    bool knownType =
+        type == protocol::FRAME_FULL || type == protocol::FRAME_DELTA;
+    if (!knownType || !protocol::checkFrame(frame, size)) {
+        // Not a frame after all, drop the sync byte and look for the next
+        m_stats.corruptFrames++;
+        m_stats.discardedBytes++;
+        return {1, false};
+    }
+
+    // Track gaps in the sequence numbers
+    std::uint8_t sequence = frame[2];
+    if (m_haveSequence) {
+        m_stats.droppedFrames +=
+            static_cast<std::uint8_t>(sequence - m_lastSequence - 1);
+    }
+    m_lastSequence = sequence;
+    m_haveSequence = true;
+    m_binary = true;
+
+    // Deltas only make sense on top of a keyframe
+    std::uint8_t mask = frame[3];
+    if (type == protocol::FRAME_FULL) {
+        m_keyframeMask = mask;
+    } else if (m_keyframeMask == 0) {
+        m_stats.skippedDeltas++;
+        return {size, false};
+    }
+
+    protocol::unpackValues(frame, m_channelValues.data());
+    std::uint8_t muteBits = frame[4];
+    std::uint8_t muteChanged = muteBits ^ m_muteBits;
+    m_muteBits = muteBits;
+
+    // Flatten the keyframe's channels into the ASCII layout: values, then
+    // mute states
+    std::size_t count = protocol::channelCount(m_keyframeMask);
+    std::size_t index = 0;
+    std::uint32_t changedChannels = 0;
+    for (std::uint8_t channel = 0; channel < protocol::MAX_CHANNELS;
+         channel++) {
+        std::uint8_t bit = 1u << channel;
+        if (!(m_keyframeMask & bit)) {
+            continue;
+        }
+        m_binaryValues[index] = m_channelValues[channel];
+        m_binaryValues[count + index] = (muteBits >> channel) & 1;
+        if ((mask | muteChanged) & bit) {
+            changedChannels |= 1u << index;
+        }
+        index++;
+    }
+
+    m_frame.values = {m_binaryValues.data(), count * 2};
+    m_frame.valueCount = static_cast<int>(count);
+    m_frame.changedChannels =
+        type == protocol::FRAME_FULL ? SerialFrame::ALL_CHANNELS
+                                     : changedChannels;
+    m_frame.keyframe = type == protocol::FRAME_FULL;
+    m_frame.hasDeviceTime = frame[1] & protocol::FRAME_FLAG_TIME;
+    m_frame.deviceTimeMs =
+        m_frame.hasDeviceTime ? protocol::frameTime(frame) : 0;
+    m_stats.framesDecoded++;
+    return {size, true};
+}
+
+FrameDecoder::Result FrameDecoder::decodeAscii(std::string_view data) {
+    std::size_t newline = data.find('\n');
+    if (newline == std::string_view::npos) {
+        if (data.size() > MAX_LINE_LENGTH) {
+            m_stats.discardedBytes += data.size();
+            return {data.size(), false};
+        }
+        return {};
+    }
+
+    // Only digits, separators and whitespace belong in a frame; anything
+    // else is noise such as a partial binary frame
+    std::string_view line = data.substr(0, newline);
+    for (char c : line) {
+        bool valid = (c >= '0' && c <= '9') || c == ',' || c == '+' ||
+                     c == '-' || c == ' ' || c == '\t' || c == '\r';
+        if (!valid) {
+            m_stats.discardedBytes += newline + 1;
+            return {newline + 1, false};
+        }
+    }
+
+    // ASCII frames always carry the complete state
+    m_frame.values = m_parser.parse(line);
+    m_frame.valueCount = SerialFrame::UNKNOWN_VALUE_COUNT;
+    m_frame.changedChannels = SerialFrame::ALL_CHANNELS;
+    m_frame.keyframe = true;
+    m_frame.hasDeviceTime = false;
+    m_stats.framesDecoded++;
+    return {newline + 1, true};
+}
+
+void FrameDecoder::reset() {
+    m_frame = {};
+    m_channelValues = {};
+    m_keyframeMask = 0;
+    m_muteBits = 0;
+    m_binary = false;
+    m_haveSequence = false;
+    m_lastSequence = 0;
+}
@@ -0,0 +1,50 @@
+#include "FrameParser.h"
+
+#include <charconv>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+           c == '\f';
+}
+
+} // namespace
+
+std::span<const int> FrameParser::parse(std::string_view line) {
+    std::size_t count = 0;
+    const char *pos = line.data();
+    const char *end = pos + line.size();
+
+    while (count < MAX_VALUES) {
+        // Locate the end of the current field
+        const char *fieldEnd = pos;
+        while (fieldEnd != end && *fieldEnd != ',') {
+            ++fieldEnd;
+        }
+
+        // Skip leading whitespace and an explicit plus sign
+        const char *first = pos;
+        while (first != fieldEnd && isSpace(*first)) {
+            ++first;
+        }
+        if (first != fieldEnd && *first == '+') {
+            ++first;
+        }
+
+        // Trailing characters after the number are ignored, invalid
+        // fields are skipped
+        int value = 0;
+        auto [ptr, ec] = std::from_chars(first, fieldEnd, value);
+        if (ec == std::errc() && ptr != first) {
+            m_values[count++] = value;
+        }
+
+        if (fieldEnd == end) {
+            break;
+        }
+        pos = fieldEnd + 1;
+    }
+
+    return {m_values.data(), count};
+}
@@ -0,0 +1,246 @@
+#include "LatencyTracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+// LatencyHistogram
+
+int LatencyHistogram::bucketIndex(std::uint64_t valueUs) {
+    if (valueUs < SUB_BUCKETS) {
+        return static_cast<int>(valueUs);
+    }
+
+    // Power of two selects the group, the next two bits the sub-bucket
+    int exponent = std::bit_width(valueUs) - 1;
+    int subBucket = static_cast<int>(valueUs >> (exponent - 2)) & 3;
+    int index = SUB_BUCKETS + (exponent - 2) * SUB_BUCKETS + subBucket;
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+
+    int exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + 2;
+    std::uint64_t subBucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    std::uint64_t width = 1ull << (exponent - 2);
+    return (SUB_BUCKETS + subBucket) * width + width - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t valueUs) {
+    m_buckets[bucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (valueUs > max &&
+           !m_max.compare_exchange_weak(max, valueUs,
+                                        std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize() const {
+    std::array<std::uint64_t, BUCKET_COUNT> counts;
+    Summary summary;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    summary.maxUs = m_max.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    // Report the upper bound of the bucket holding each percentile
+    std::uint64_t p50Rank = (summary.count * 50 + 99) / 100;
+    std::uint64_t p99Rank = (summary.count * 99 + 99) / 100;
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (summary.p50Us == 0 && seen >= p50Rank) {
+            summary.p50Us = bucketUpperBound(i);
+        }
+        if (seen >= p99Rank) {
+            summary.p99Us = bucketUpperBound(i);
+            break;
+        }
+    }
+    summary.p50Us = std::min(summary.p50Us, summary.maxUs);
+    summary.p99Us = std::min(summary.p99Us, summary.maxUs);
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (auto &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+// LatencyTracer
+
+LatencyTracer &LatencyTracer::global() {
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+LatencyTracer::~LatencyTracer() { stop(); }
+
+std::uint64_t LatencyTracer::nowUs() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+const char *LatencyTracer::stageName(Stage stage) {
+    switch (stage) {
+    case Stage::Transport:
+        return "transport";
+    case Stage::Parse:
+        return "parse";
+    case Stage::Dispatch:
+        return "dispatch";
+    case Stage::Queue:
+        return "queue";
+    case Stage::Backend:
+        return "backend";
+    case Stage::EndToEnd:
+        return "end_to_end";
+    default:
+        return "unknown";
+    }
+}
+
+std::uint16_t LatencyTracer::threadNumber() {
+    // Small stable numbers read better in trace viewers than thread IDs
+    static std::atomic<std::uint16_t> nextThread{1};
+    thread_local std::uint16_t thread = nextThread++;
+    return thread;
+}
+
+void LatencyTracer::enable(unsigned int logIntervalMs,
+                           const std::string &chromeTracePath) {
+    if (m_enabled) {
+        return;
+    }
+
+    m_chromeTracePath = chromeTracePath;
+    if (!m_chromeTracePath.empty() && !m_events) {
+        m_events = std::make_unique<TraceEvent[]>(MAX_TRACE_EVENTS);
+    }
+    m_enabled = true;
+
+    if (logIntervalMs > 0) {
+        m_reportThread = std::jthread(
+            [this, logIntervalMs](std::stop_token stopToken) {
+                reportThread(stopToken, logIntervalMs);
+            });
+    }
+}
+
+void LatencyTracer::stop() {
+    if (!m_enabled) {
+        return;
+    }
+
+    m_enabled = false;
+    if (m_reportThread.joinable()) {
+        m_reportThread.request_stop();
+        m_reportThread.join();
+    }
+    if (!m_chromeTracePath.empty()) {
+        writeChromeTrace(m_chromeTracePath);
+    }
+}
+
+void LatencyTracer::record(Stage stage, std::uint64_t startUs,
+                           std::uint64_t endUs) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    std::uint64_t durationUs = endUs > startUs ? endUs - startUs : 0;
+    m_histograms[static_cast<int>(stage)].record(durationUs);
+
+    if (m_events) {
+        std::size_t index =
+            m_eventCount.fetch_add(1, std::memory_order_relaxed);
+        if (index < MAX_TRACE_EVENTS) {
+            m_events[index] = {startUs, static_cast<std::uint32_t>(durationUs),
+                               static_cast<std::uint16_t>(stage),
+                               threadNumber()};
+        }
+    }
+}
+
+void LatencyTracer::recordDeviceTime(DeviceClock &clock,
+                                     std::uint32_t deviceMs,
+                                     std::uint64_t receivedUs) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    // The clocks are not synchronised, so measure the offset against the
+    // lowest one seen from this device; what remains is transport and
+    // buffering delay
+    std::int64_t offsetUs = static_cast<std::int64_t>(receivedUs) -
+                            static_cast<std::int64_t>(deviceMs) * 1000;
+    clock.minOffsetUs = std::min(clock.minOffsetUs, offsetUs);
+
+    record(Stage::Transport, receivedUs - (offsetUs - clock.minOffsetUs),
+           receivedUs);
+}
+
+LatencyHistogram::Summary LatencyTracer::summarize(Stage stage) const {
+    return m_histograms[static_cast<int>(stage)].summarize();
+}
+
+void LatencyTracer::writeSummary(std::ostream &out) const {
+    out << "Latency (p50/p99/max us):";
+    bool empty = true;
+    for (int i = 0; i < static_cast<int>(Stage::Count); i++) {
+        LatencyHistogram::Summary summary = m_histograms[i].summarize();
+        if (summary.count == 0) {
+            continue;
+        }
+        out << ' ' << stageName(static_cast<Stage>(i)) << '='
+            << summary.p50Us << '/' << summary.p99Us << '/' << summary.maxUs;
+        empty = false;
+    }
+    out << (empty ? " no samples" : "") << std::endl;
+}
+
+bool LatencyTracer::writeChromeTrace(const std::string &path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to write trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::size_t count = std::min(m_eventCount.load(), MAX_TRACE_EVENTS);
+    file << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < count && m_events; i++) {
+        const TraceEvent &event = m_events[i];
+        file << (i > 0 ? ",\n" : "\n") << "{\"name\":\""
+             << stageName(static_cast<Stage>(event.stage))
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+             << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+             << "}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+void LatencyTracer::reportThread(std::stop_token stopToken,
+                                 unsigned int intervalMs) {
+    std::unique_lock<std::mutex> lock(m_reportMutex);
+    while (!stopToken.stop_requested()) {
+        m_reportCondition.wait_for(lock, stopToken,
+                                   std::chrono::milliseconds(intervalMs),
+                                   [] { return false; });
+        if (!stopToken.stop_requested()) {
+            writeSummary(std::cout);
+        }
+    }
+}
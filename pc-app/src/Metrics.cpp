@@ -0,0 +1,177 @@
+#include "Metrics.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// Microseconds as seconds, without the trailing zeros of fixed notation
+void writeSeconds(std::ostream &out, std::uint64_t valueUs) {
+    out << valueUs / 1000000;
+    std::uint64_t fraction = valueUs % 1000000;
+    if (fraction == 0) {
+        return;
+    }
+
+    char digits[7] = "000000";
+    for (int i = 5; i >= 0; i--) {
+        digits[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    int length = 6;
+    while (digits[length - 1] == '0') {
+        length--;
+    }
+    out << '.' << std::string_view(digits, length);
+}
+
+// Series name with its labels and an optional extra label, e.g.
+// name_bucket{port="COM3",le="0.001"}
+void writeSeriesName(std::ostream &out, std::string_view name,
+                     std::string_view labels, std::string_view extra = {}) {
+    out << name;
+    if (labels.empty() && extra.empty()) {
+        return;
+    }
+    out << '{' << labels;
+    if (!labels.empty() && !extra.empty()) {
+        out << ',';
+    }
+    out << extra << '}';
+}
+
+} // namespace
+
+// MetricHistogram
+
+MetricHistogram::MetricHistogram(std::span<const std::uint64_t> boundsUs)
+    : m_boundsUs(boundsUs.begin(), boundsUs.end()),
+      m_buckets(new std::atomic<std::uint64_t>[boundsUs.size() + 1]) {
+    std::sort(m_boundsUs.begin(), m_boundsUs.end());
+    for (std::size_t i = 0; i <= m_boundsUs.size(); i++) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::record(std::uint64_t valueUs) {
+    std::size_t bucket = std::lower_bound(m_boundsUs.begin(),
+                                          m_boundsUs.end(), valueUs) -
+                         m_boundsUs.begin();
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumUs.fetch_add(valueUs, std::memory_order_relaxed);
+}
+
+// MetricsRegistry
+
+MetricsRegistry &MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Series &
+MetricsRegistry::findSeries(std::string_view name, std::string_view help,
+                            bool histogram, std::string_view labels) {
+    auto family = std::find_if(
+        m_families.begin(), m_families.end(),
+        [name](const Family &family) { return family.name == name; });
+    if (family == m_families.end()) {
+        m_families.push_back(
+            {std::string(name), std::string(help), histogram, {}});
+        family = m_families.end() - 1;
+    } else if (family->histogram != histogram) {
+        throw std::runtime_error("Metric " + std::string(name) +
+                                 " registered with another type");
+    }
+
+    auto series = std::find_if(
+        family->series.begin(), family->series.end(),
+        [labels](const Series &series) { return series.labels == labels; });
+    if (series != family->series.end()) {
+        return *series;
+    }
+    family->series.push_back({std::string(labels)});
+    return family->series.back();
+}
+
+MetricCounter &MetricsRegistry::counter(std::string_view name,
+                                        std::string_view help,
+                                        std::string_view labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series &series = findSeries(name, help, false, labels);
+    if (!series.counter) {
+        series.counter = &m_counters.emplace_back();
+    }
+    return *series.counter;
+}
+
+MetricHistogram &
+MetricsRegistry::histogram(std::string_view name, std::string_view help,
+                           std::span<const std::uint64_t> boundsUs,
+                           std::string_view labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Series &series = findSeries(name, help, true, labels);
+    if (!series.histogram) {
+        series.histogram = &m_histograms.emplace_back(boundsUs);
+    }
+    return *series.histogram;
+}
+
+std::string MetricsRegistry::label(std::string_view name,
+                                   std::string_view value) {
+    std::string result(name);
+    result += "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+void MetricsRegistry::writePrometheus(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Family &family : m_families) {
+        out << "# HELP " << family.name << ' ' << family.help << '\n'
+            << "# TYPE " << family.name << ' '
+            << (family.histogram ? "histogram" : "counter") << '\n';
+
+        for (const Series &series : family.series) {
+            if (series.counter) {
+                writeSeriesName(out, family.name, series.labels);
+                out << ' ' << series.counter->value() << '\n';
+                continue;
+            }
+
+            // Buckets are cumulative; the count is taken from them so the
+            // +Inf bucket always matches it
+            const MetricHistogram &histogram = *series.histogram;
+            std::span<const std::uint64_t> bounds = histogram.boundsUs();
+            std::string bucketName = family.name + "_bucket";
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i <= bounds.size(); i++) {
+                cumulative += histogram.bucketCount(i);
+                std::string le = "le=\"+Inf\"";
+                if (i < bounds.size()) {
+                    std::ostringstream bound;
+                    writeSeconds(bound, bounds[i]);
+                    le = "le=\"" + bound.str() + '"';
+                }
+                writeSeriesName(out, bucketName, series.labels, le);
+                out << ' ' << cumulative << '\n';
+            }
+            writeSeriesName(out, family.name + "_sum", series.labels);
+            out << ' ';
+            writeSeconds(out, histogram.sumUs());
+            out << '\n';
+            writeSeriesName(out, family.name + "_count", series.labels);
+            out << ' ' << cumulative << '\n';
+        }
+    }
+}
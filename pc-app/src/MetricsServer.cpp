@@ -0,0 +1,151 @@
+#include "MetricsServer.h"
+
+#include <boost/asio.hpp>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using boost::asio::ip::tcp;
+
+// Requests larger than this are not scrapes and are dropped
+constexpr std::size_t MAX_REQUEST_SIZE = 8192;
+
+std::string httpResponse(std::string_view status, std::string_view type,
+                         std::string_view body) {
+    std::string response = "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += type;
+    response += "\r\nContent-Length: " + std::to_string(body.size()) +
+                "\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+// One request and response, then the connection is closed
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    Connection(tcp::socket socket, MetricsRegistry &registry)
+        : m_socket(std::move(socket)), m_request(MAX_REQUEST_SIZE),
+          m_registry(registry) {}
+
+    void start() {
+        auto self = shared_from_this();
+        boost::asio::async_read_until(
+            m_socket, m_request, "\r\n\r\n",
+            [self](const boost::system::error_code &error, std::size_t) {
+                if (!error) {
+                    self->respond();
+                }
+            });
+    }
+
+private:
+    void respond() {
+        std::istream request(&m_request);
+        std::string method, target;
+        request >> method >> target;
+
+        if (method != "GET") {
+            m_response = httpResponse("405 Method Not Allowed", "text/plain",
+                                      "Only GET is supported\n");
+        } else if (target == "/metrics" || target.starts_with("/metrics?")) {
+            std::ostringstream body;
+            m_registry.writePrometheus(body);
+            m_response = httpResponse(
+                "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                body.str());
+        } else {
+            m_response =
+                httpResponse("404 Not Found", "text/plain", "Try /metrics\n");
+        }
+
+        auto self = shared_from_this();
+        boost::asio::async_write(
+            m_socket, boost::asio::buffer(m_response),
+            [self](const boost::system::error_code &, std::size_t) {
+                boost::system::error_code ignored;
+                self->m_socket.shutdown(tcp::socket::shutdown_both, ignored);
+            });
+    }
+
+    tcp::socket m_socket;
+    boost::asio::streambuf m_request;
+    std::string m_response;
+    MetricsRegistry &m_registry;
+};
+
+} // namespace
+
+struct MetricsServer::State {
+    State(MetricsRegistry &registry, unsigned short port)
+        : registry(registry), port(port), acceptor(ioContext) {}
+
+    void accept() {
+        acceptor.async_accept([this](const boost::system::error_code &error,
+                                     tcp::socket socket) {
+            if (error == boost::asio::error::operation_aborted) {
+                return;
+            }
+            if (!error) {
+                std::make_shared<Connection>(std::move(socket), registry)
+                    ->start();
+            }
+            accept();
+        });
+    }
+
+    MetricsRegistry &registry;
+    unsigned short port;
+    boost::asio::io_context ioContext;
+    tcp::acceptor acceptor;
+    std::jthread thread;
+};
+
+MetricsServer::MetricsServer(MetricsRegistry &registry, unsigned short port)
+    : m_state(std::make_unique<State>(registry, port)) {}
+
+MetricsServer::~MetricsServer() { stop(); }
+
+bool MetricsServer::start() {
+    if (m_state->thread.joinable()) {
+        return true;
+    }
+
+    try {
+        tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(),
+                               m_state->port);
+        m_state->acceptor.open(endpoint.protocol());
+        m_state->acceptor.set_option(tcp::acceptor::reuse_address(true));
+        m_state->acceptor.bind(endpoint);
+        m_state->acceptor.listen();
+    } catch (const std::exception &e) {
+        std::cerr << "Metrics not served on port " << m_state->port << ": "
+                  << e.what() << std::endl;
+        boost::system::error_code ignored;
+        m_state->acceptor.close(ignored);
+        return false;
+    }
+
+    std::cout << "Serving metrics on http://127.0.0.1:" << m_state->port
+              << "/metrics" << std::endl;
+    m_state->ioContext.restart();
+    m_state->accept();
+    m_state->thread = std::jthread([this] { m_state->ioContext.run(); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!m_state->thread.joinable()) {
+        return;
+    }
+
+    // Connections still open are dropped with the context's handlers
+    m_state->ioContext.stop();
+    m_state->thread.join();
+    boost::system::error_code ignored;
+    m_state->acceptor.close(ignored);
+}
@@ -0,0 +1,57 @@
+#include "ResponseCurve.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Volume at knob position 0.0 to 1.0
+double evaluate(const CurveSettings &settings, double position) {
+    switch (settings.type) {
+    case CurveType::Linear:
+        break;
+    case CurveType::Logarithmic:
+        if (position <= 0.0) {
+            return 0.0;
+        }
+        return std::pow(10.0, -settings.rangeDb * (1.0 - position) / 20.0);
+    case CurveType::Table: {
+        const std::vector<double> &points = settings.points;
+        if (points.size() < 2) {
+            break;
+        }
+        double index = position * (points.size() - 1);
+        std::size_t lower = std::min(static_cast<std::size_t>(index),
+                                     points.size() - 2);
+        double fraction = index - lower;
+        return points[lower] + (points[lower + 1] - points[lower]) * fraction;
+    }
+    }
+    return position;
+}
+
+} // namespace
+
+ResponseCurve::ResponseCurve(const CurveSettings &settings, bool invert) {
+    for (int i = 0; i < SIZE; i++) {
+        double position = static_cast<double>(i) / (SIZE - 1);
+        if (invert) {
+            position = 1.0 - position;
+        }
+        m_table[i] =
+            static_cast<float>(std::clamp(evaluate(settings, position), 0.0,
+                                          1.0));
+    }
+}
+
+int ResponseCurve::position(float volumeLevel) const {
+    // Table curves need not be monotonic, so search the whole table
+    int best = 0;
+    for (int i = 1; i < SIZE; i++) {
+        if (std::abs(m_table[i] - volumeLevel) <
+            std::abs(m_table[best] - volumeLevel)) {
+            best = i;
+        }
+    }
+    return best;
+}
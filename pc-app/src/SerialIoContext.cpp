@@ -0,0 +1,31 @@
+#include "SerialIoContext.h"
+
+#include <algorithm>
+
+SerialIoContext::SerialIoContext(unsigned int threadCount)
+    : m_threadCount(std::max(threadCount, 1u)),
+      m_ioContext(static_cast<int>(m_threadCount)) {}
+
+SerialIoContext::~SerialIoContext() { stop(); }
+
+void SerialIoContext::start() {
+    if (!m_threads.empty()) {
+        return;
+    }
+
+    m_ioContext.restart();
+    m_workGuard.emplace(m_ioContext.get_executor());
+    for (unsigned int i = 0; i < m_threadCount; i++) {
+        m_threads.emplace_back([this] { m_ioContext.run(); });
+    }
+}
+
+void SerialIoContext::stop() {
+    if (m_threads.empty()) {
+        return;
+    }
+
+    m_workGuard.reset();
+    m_ioContext.stop();
+    m_threads.clear(); // Joins
+}
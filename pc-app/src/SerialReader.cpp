@@ -1,12 +1,59 @@
 #include "SerialReader.h"
 
+#include "LatencyTracer.h"
+#include "VolwareProtocol.h"
+
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
-#include <sstream>
+#include <string_view>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
 
-SerialReader::SerialReader(const std::string &port, unsigned int baudRate)
-    : m_portName(port), m_baudRate(baudRate), m_serialPort(m_ioService) {
-    m_syncTimer = std::make_unique<boost::asio::steady_timer>(m_ioService);
+MetricCounter &frameErrorCounter(const std::string &port,
+                                 std::string_view kind) {
+    return MetricsRegistry::global().counter(
+        "volware_serial_frame_errors_total",
+        "Frames lost to corruption or gaps in the sequence",
+        MetricsRegistry::label("port", port) + "," +
+            MetricsRegistry::label("kind", kind));
+}
+
+} // namespace
+
+SerialReader::PortMetrics::PortMetrics(const std::string &port)
+    : frames(MetricsRegistry::global().counter(
+          "volware_serial_frames_total", "Frames decoded",
+          MetricsRegistry::label("port", port))),
+      corruptFrames(frameErrorCounter(port, "corrupt")),
+      droppedFrames(frameErrorCounter(port, "dropped")),
+      discardedBytes(MetricsRegistry::global().counter(
+          "volware_serial_discarded_bytes_total",
+          "Bytes skipped while looking for a frame",
+          MetricsRegistry::label("port", port))),
+      reconnects(MetricsRegistry::global().counter(
+          "volware_serial_reconnects_total",
+          "Times the port was lost and reconnecting began",
+          MetricsRegistry::label("port", port))) {}
+
+SerialReader::SerialReader(boost::asio::io_context &ioContext,
+                           const std::string &port, unsigned int baudRate)
+    : m_portName(port), m_baudRate(baudRate),
+      m_strand(boost::asio::make_strand(ioContext)), m_serialPort(m_strand),
+      m_metrics(port), m_reconnectTimer(m_strand)
+#ifdef __linux__
+      ,
+      m_deviceWatch(m_strand)
+#endif
+{
+    m_syncTimer = std::make_unique<boost::asio::steady_timer>(m_strand);
 }
 
 SerialReader::~SerialReader() { stop(); }
@@ -17,7 +64,11 @@ bool SerialReader::start() {
     }
 
     m_running = true;
-    m_workerThread = std::jthread(&SerialReader::workerThread, this);
+    auto begin = [this] {
+        watchDevice();
+        connect();
+    };
+    boost::asio::post(m_strand, tracked(begin));
     return true;
 }
 
@@ -26,11 +77,51 @@ void SerialReader::stop() {
         return;
     }
 
+    // Tear down on the strand, then wait for the cancelled operations'
+    // handlers, which still refer to this reader
     m_running = false;
-    if (m_connected) {
+    auto teardown = [this] {
+        m_reconnectTimer.cancel();
+#ifdef __linux__
+        boost::system::error_code ignored;
+        m_deviceWatch.close(ignored);
+#endif
         closePort();
+    };
+    boost::asio::post(m_strand, tracked(teardown));
+
+    std::unique_lock<std::mutex> lock(m_operationMutex);
+    m_operationsDone.wait(lock, [this] { return m_operations == 0; });
+}
+
+void SerialReader::requestSync() {
+    if (m_running) {
+        boost::asio::post(m_strand, tracked([this] {
+            m_syncAttempts = 0;
+            sendSyncMessage();
+        }));
+    }
+}
+
+void SerialReader::sendHostState(std::uint8_t mask, std::uint8_t muteBits,
+                                 std::span<const int> values) {
+    if (!m_running) {
+        return;
     }
-    m_ioService.stop();
+
+    int channelValues[volware::protocol::MAX_CHANNELS] = {};
+    std::copy_n(values.begin(),
+                std::min<std::size_t>(values.size(),
+                                      volware::protocol::MAX_CHANNELS),
+                channelValues);
+    char buffer[volware::protocol::MAX_HOST_STATE_SIZE];
+    std::uint8_t length = volware::protocol::encodeHostState(
+        buffer, mask, muteBits, channelValues);
+
+    boost::asio::post(m_strand,
+                      tracked([this, message = std::string(buffer, length)] {
+                          sendMessage(message);
+                      }));
 }
 
 bool SerialReader::openPort() {
@@ -50,15 +141,26 @@ bool SerialReader::openPort() {
         std::cout << "Serial port opened: " << m_portName << std::endl;
         m_connected = true;
 
-        scheduleSyncTimer();
+        // Start from a clean stream state
+        m_readBuffer.consume(m_readBuffer.size());
+        m_frameDecoder.reset();
+        m_deviceClock.reset(); // The device may have restarted
+
+        // Ask for the full state right away
+        m_syncAttempts = 0;
+        sendSyncMessage();
     } catch (const std::exception &e) {
-        std::cerr << "Error opening port: " << e.what() << std::endl;
+        // Only report the first failure of an outage
+        if (m_reconnectAttempts == 0) {
+            std::cerr << "Error opening port: " << e.what() << std::endl;
+        }
         return false;
     }
     return true;
 }
 
 bool SerialReader::closePort() {
+    m_syncTimer->cancel();
     if (m_serialPort.is_open()) {
         try {
             m_serialPort.cancel();
@@ -72,6 +174,115 @@ bool SerialReader::closePort() {
     return true;
 }
 
+void SerialReader::connect() {
+    if (!m_running || m_connected) {
+        return;
+    }
+
+    if (openPort()) {
+        readStart();
+    } else {
+        scheduleReconnect();
+    }
+}
+
+void SerialReader::scheduleReconnect() {
+    // Exponential backoff with jitter: half the delay is fixed, the other
+    // half random, so several readers do not retry in lockstep
+    unsigned int shift = std::min(m_reconnectAttempts, 16u);
+    unsigned int delayMs =
+        std::min(RECONNECT_MIN_DELAY_MS << shift, RECONNECT_MAX_DELAY_MS);
+    delayMs = delayMs / 2 +
+              std::uniform_int_distribution<unsigned int>(0, delayMs / 2)(
+                  m_random);
+    m_reconnectAttempts++;
+
+    m_reconnectTimer.expires_after(std::chrono::milliseconds(delayMs));
+    m_reconnectTimer.async_wait(
+        tracked([this](const boost::system::error_code &error) {
+            if (!error) {
+                connect();
+            }
+        }));
+}
+
+void SerialReader::handleDisconnect() {
+    if (!m_connected) {
+        return;
+    }
+
+    closePort();
+    m_metrics.reconnects.add();
+    m_reconnectAttempts = 0;
+    scheduleReconnect();
+}
+
+void SerialReader::watchDevice() {
+#ifdef __linux__
+    // Watch the directory holding the port, e.g. /dev or /dev/serial/by-id
+    std::filesystem::path directory =
+        std::filesystem::path(m_portName).parent_path();
+    if (directory.empty()) {
+        return;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    // udev creates the node first and fixes its permissions afterwards, so
+    // attribute changes count as an arrival too
+    if (inotify_add_watch(fd, directory.c_str(),
+                          IN_CREATE | IN_ATTRIB | IN_MOVED_TO) < 0) {
+        std::cerr << "Not watching " << directory.string()
+                  << " for the device, relying on retries." << std::endl;
+        close(fd);
+        return;
+    }
+
+    m_deviceWatch.assign(fd);
+    readDeviceEvents();
+#endif
+}
+
+void SerialReader::readDeviceEvents() {
+#ifdef __linux__
+    m_deviceWatch.async_read_some(
+        boost::asio::buffer(m_deviceEvents),
+        tracked([this](const boost::system::error_code &error,
+                       std::size_t size) {
+            if (error || !m_running) {
+                return;
+            }
+
+            std::string deviceName =
+                std::filesystem::path(m_portName).filename().string();
+            bool arrived = false;
+            for (std::size_t offset = 0;
+                 offset + sizeof(inotify_event) <= size;) {
+                inotify_event event;
+                std::memcpy(&event, m_deviceEvents.data() + offset,
+                            sizeof(event));
+                const char *name =
+                    m_deviceEvents.data() + offset + sizeof(inotify_event);
+                if (event.len > 0 && deviceName == name) {
+                    arrived = true;
+                }
+                offset += sizeof(inotify_event) + event.len;
+            }
+
+            // Skip the remaining backoff and try right away
+            if (arrived && !m_connected) {
+                m_reconnectTimer.cancel();
+                m_reconnectAttempts = 0;
+                connect();
+            }
+            readDeviceEvents();
+        }));
+#endif
+}
+
 void SerialReader::sendMessage(const std::string &message,
                                std::function<void(bool success)> callback) {
     if (!m_connected || !m_serialPort.is_open()) {
@@ -86,8 +297,9 @@ void SerialReader::sendMessage(const std::string &message,
 
     boost::asio::async_write(
         m_serialPort, boost::asio::buffer(*messageBuffer),
-        [this, messageBuffer, callback](const boost::system::error_code &error,
-                                        std::size_t bytes_transferred) {
+        tracked([messageBuffer,
+                 callback](const boost::system::error_code &error,
+                           std::size_t /*bytesTransferred*/) {
             if (error) {
                 std::cerr << "Error sending message: " << error.message()
                           << std::endl;
@@ -99,35 +311,50 @@ void SerialReader::sendMessage(const std::string &message,
             if (callback) {
                 callback(true);
             }
-        });
+        }));
 }
 
 void SerialReader::sendSyncMessage() {
     if (m_connected && m_running) {
-        sendMessage(m_syncMessage, [this](bool success) {
+        // Ask for binary frames ahead of every sync; firmware without
+        // binary support ignores the request and keeps sending ASCII
+        std::string message = m_syncMessage;
+        if (m_protocol == SerialProtocol::Binary) {
+            message.insert(message.begin(),
+                           volware::protocol::REQUEST_BINARY);
+        }
+
+        m_syncAttempts++;
+        sendMessage(message, [this](bool success) {
             if (!success) {
                 std::cerr << "Failed to send sync message." << std::endl;
-                m_connected = false;
-                closePort();
-                m_ioService.reset();
+                handleDisconnect();
                 return;
             }
-            scheduleSyncTimer();
+            scheduleSyncRetry();
         });
     }
 }
 
-void SerialReader::scheduleSyncTimer() {
+void SerialReader::scheduleSyncRetry() {
     if (!m_running || !m_connected) {
         return;
     }
 
-    m_syncTimer->expires_after(std::chrono::milliseconds(SYNC_INTERVAL_MS));
-    m_syncTimer->async_wait([this](const boost::system::error_code &error) {
-        if (!error && m_running && m_connected) {
-            sendSyncMessage();
-        }
-    });
+    // Firmware without binary support never answers in binary; it keeps
+    // sending ASCII frames once the attempts are used up
+    if (m_syncAttempts >= SYNC_MAX_ATTEMPTS) {
+        m_syncAttempts = 0;
+        return;
+    }
+
+    m_syncTimer->expires_after(std::chrono::milliseconds(SYNC_RETRY_MS));
+    m_syncTimer->async_wait(
+        tracked([this](const boost::system::error_code &error) {
+            if (!error && m_running && m_connected && m_syncAttempts > 0) {
+                sendSyncMessage();
+            }
+        }));
 }
 
 void SerialReader::readStart() {
@@ -135,41 +362,87 @@ void SerialReader::readStart() {
         return;
     }
 
-    boost::asio::async_read_until(m_serialPort, m_readBuffer, '\n',
-                                  std::bind(&SerialReader::readComplete, this,
-                                            std::placeholders::_1,
-                                            std::placeholders::_2));
+    boost::asio::async_read(
+        m_serialPort, m_readBuffer, boost::asio::transfer_at_least(1),
+        tracked([this](const boost::system::error_code &error,
+                       std::size_t bytesTransferred) {
+            readComplete(error, bytesTransferred);
+        }));
 }
 
 void SerialReader::readComplete(const boost::system::error_code &error,
-                                size_t bytesTransferred) {
-    if (!m_running) {
+                                size_t /*bytesTransferred*/) {
+    if (!m_running || error == boost::asio::error::operation_aborted) {
         return;
     }
 
     if (!error) {
-        // Read the line from the buffer
-        std::istream is(&m_readBuffer);
-        std::string line;
-        std::getline(is, line);
-
-        // Parse comma-separated values
-        std::vector<int> values;
-        std::string item;
-        std::istringstream iss(line);
-
-        while (std::getline(iss, item, ',')) {
-            try {
-                int value = std::stoi(item);
-                values.push_back(value);
-            } catch (const std::exception &) {
-                // Skip invalid values
+        // Timestamps are only taken while latency tracing is enabled
+        LatencyTracer &tracer = LatencyTracer::global();
+        bool tracing = tracer.isEnabled();
+        std::uint64_t receivedUs = tracing ? LatencyTracer::nowUs() : 0;
+
+        // Decode every complete frame straight from the read buffer
+        while (m_readBuffer.size() > 0) {
+            std::string_view data(
+                static_cast<const char *>(m_readBuffer.data().data()),
+                m_readBuffer.size());
+            std::uint64_t parseStartUs = tracing ? LatencyTracer::nowUs() : 0;
+            FrameDecoder::Result result = m_frameDecoder.decode(data);
+
+            // A keyframe in the requested format answers the sync request
+            if (result.frameReady && m_syncAttempts > 0 &&
+                m_frameDecoder.frame().keyframe &&
+                (m_protocol == SerialProtocol::Ascii ||
+                 m_frameDecoder.isBinary())) {
+                m_syncAttempts = 0;
+                m_syncTimer->cancel();
+            }
+
+            if (result.frameReady && m_callback) {
+                SerialFrame frame = m_frameDecoder.frame();
+                frame.receivedUs = receivedUs;
+
+                if (tracing) {
+                    std::uint64_t parsedUs = LatencyTracer::nowUs();
+                    tracer.record(LatencyTracer::Stage::Parse, parseStartUs,
+                                  parsedUs);
+                    if (frame.hasDeviceTime) {
+                        tracer.recordDeviceTime(
+                            m_deviceClock, frame.deviceTimeMs, receivedUs);
+                    }
+                    m_callback(frame);
+                    tracer.record(LatencyTracer::Stage::Dispatch, parsedUs,
+                                  LatencyTracer::nowUs());
+                } else {
+                    m_callback(frame);
+                }
             }
+            if (result.consumed == 0) {
+                break;
+            }
+            m_readBuffer.consume(result.consumed);
         }
 
-        // Invoke callback with parsed values
-        if (m_callback) {
-            m_callback(values);
+        // Export what the decoder counted in this read
+        const FrameDecoder::Stats &stats = m_frameDecoder.stats();
+        m_metrics.frames.add(stats.framesDecoded -
+                             m_exportedStats.framesDecoded);
+        m_metrics.corruptFrames.add(stats.corruptFrames -
+                                    m_exportedStats.corruptFrames);
+        m_metrics.droppedFrames.add(stats.droppedFrames -
+                                    m_exportedStats.droppedFrames);
+        m_metrics.discardedBytes.add(stats.discardedBytes -
+                                     m_exportedStats.discardedBytes);
+        m_exportedStats = stats;
+
+        // Report lost or corrupted binary frames
+        std::uint32_t frameErrors = stats.droppedFrames + stats.corruptFrames;
+        if (frameErrors != m_reportedFrameErrors) {
+            std::cerr << "Serial frames lost: " << stats.droppedFrames
+                      << " dropped, " << stats.corruptFrames << " corrupt"
+                      << std::endl;
+            m_reportedFrameErrors = frameErrors;
         }
 
         // Continue reading
@@ -177,26 +450,6 @@ void SerialReader::readComplete(const boost::system::error_code &error,
     } else {
         std::cerr << "Error reading from serial port: " << error.message()
                   << std::endl;
-        closePort();
-        m_ioService.reset();
+        handleDisconnect();
     }
 }
-
-void SerialReader::workerThread() {
-    while (m_running) {
-        if (!m_connected) {
-            if (openPort()) {
-                readStart();
-                m_ioService.run();
-                m_ioService.reset();
-            } else {
-                // Wait before reconnecting
-                std::this_thread::sleep_for(
-                    std::chrono::milliseconds(RECONNECT_INTERVAL_MS));
-            }
-        } else {
-            // Small sleep to prevent CPU hogging
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-    }
-}
\ No newline at end of file
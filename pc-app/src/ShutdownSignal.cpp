@@ -0,0 +1,217 @@
+#include "ShutdownSignal.h"
+
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32) || defined(_WIN64)
+// windows.h is included by the header
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#endif
+#endif
+
+namespace {
+
+#if defined(_WIN32) || defined(_WIN64)
+
+// Event of the instance that handles console control events
+HANDLE g_consoleEvent = NULL;
+
+BOOL WINAPI handleConsoleControl(DWORD controlType) {
+    switch (controlType) {
+    case CTRL_C_EVENT:
+    case CTRL_BREAK_EVENT:
+    case CTRL_CLOSE_EVENT:
+        SetEvent(g_consoleEvent);
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+#else
+
+std::runtime_error systemError(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+#if !defined(__linux__)
+
+// Write end of the pipe of the instance that handles the signals
+int g_signalPipe = -1;
+
+void handleSignal(int) {
+    char byte = 1;
+    [[maybe_unused]] ssize_t written = write(g_signalPipe, &byte, 1);
+}
+
+#endif
+
+#endif
+
+} // namespace
+
+#if defined(_WIN32) || defined(_WIN64)
+
+ShutdownSignal::ShutdownSignal() {
+    m_event = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (m_event == NULL) {
+        throw std::runtime_error("Failed to create the shutdown event.");
+    }
+    g_consoleEvent = m_event;
+    SetConsoleCtrlHandler(handleConsoleControl, TRUE);
+}
+
+ShutdownSignal::~ShutdownSignal() {
+    SetConsoleCtrlHandler(handleConsoleControl, FALSE);
+    g_consoleEvent = NULL;
+    CloseHandle(m_event);
+}
+
+void ShutdownSignal::request() {
+    m_requested = true;
+    SetEvent(m_event);
+}
+
+void ShutdownSignal::wait() {
+    while (!m_requested) {
+        DWORD result = MsgWaitForMultipleObjectsEx(
+            1, &m_event, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        if (result == WAIT_OBJECT_0) {
+            m_requested = true; // Console control events set it directly
+            break;
+        }
+        if (result != WAIT_OBJECT_0 + 1) {
+            throw std::runtime_error("Waiting for shutdown failed.");
+        }
+
+        // Dispatch everything queued, then sleep again
+        MSG msg;
+        while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                m_requested = true;
+                break;
+            }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    }
+}
+
+#elif defined(__linux__)
+
+ShutdownSignal::ShutdownSignal() {
+    // Delivered through the signalfd only, in this thread and in every
+    // thread started later
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    int error = pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    if (error != 0) {
+        errno = error;
+        throw systemError("Failed to block termination signals");
+    }
+
+    m_signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m_signalFd < 0) {
+        throw systemError("Failed to create signalfd");
+    }
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_eventFd < 0) {
+        close(m_signalFd);
+        throw systemError("Failed to create eventfd");
+    }
+}
+
+ShutdownSignal::~ShutdownSignal() {
+    close(m_signalFd);
+    close(m_eventFd);
+}
+
+void ShutdownSignal::request() {
+    m_requested = true;
+    std::uint64_t one = 1;
+    [[maybe_unused]] ssize_t written = write(m_eventFd, &one, sizeof(one));
+}
+
+void ShutdownSignal::wait() {
+    pollfd fds[] = {{m_signalFd, POLLIN, 0}, {m_eventFd, POLLIN, 0}};
+    while (!m_requested) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("Waiting for shutdown failed");
+        }
+        if (fds[0].revents & POLLIN) {
+            signalfd_siginfo info;
+            if (read(m_signalFd, &info, sizeof(info)) == sizeof(info)) {
+                m_requested = true;
+            }
+        }
+        if (fds[1].revents & POLLIN) {
+            m_requested = true;
+        }
+    }
+}
+
+#else
+
+ShutdownSignal::ShutdownSignal() {
+    if (pipe(m_pipe) != 0) {
+        throw systemError("Failed to create the shutdown pipe");
+    }
+    for (int fd : m_pipe) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+    }
+
+    g_signalPipe = m_pipe[1];
+    struct sigaction action {};
+    action.sa_handler = handleSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+ShutdownSignal::~ShutdownSignal() {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    g_signalPipe = -1;
+    close(m_pipe[0]);
+    close(m_pipe[1]);
+}
+
+void ShutdownSignal::request() {
+    m_requested = true;
+    char byte = 1;
+    [[maybe_unused]] ssize_t written = write(m_pipe[1], &byte, 1);
+}
+
+void ShutdownSignal::wait() {
+    pollfd fds[] = {{m_pipe[0], POLLIN, 0}};
+    while (!m_requested) {
+        if (poll(fds, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("Waiting for shutdown failed");
+        }
+        if (fds[0].revents & POLLIN) {
+            m_requested = true;
+        }
+    }
+}
+
+#endif
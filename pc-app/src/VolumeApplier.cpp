@@ -0,0 +1,169 @@
+#include "VolumeApplier.h"
+
+#include "LatencyTracer.h"
+
+#include <bit>
+
+namespace {
+
+// Bucket bounds of the receive-to-applied latency histogram
+constexpr std::uint64_t APPLY_LATENCY_BOUNDS_US[] = {
+    250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000};
+
+} // namespace
+
+VolumeApplier::VolumeApplier(ApplyFunction apply)
+    : m_apply(std::move(apply)),
+      m_coalescedMetric(MetricsRegistry::global().counter(
+          "volware_updates_coalesced_total",
+          "Channel values replaced by a newer one before being applied")),
+      m_appliedMetric(MetricsRegistry::global().counter(
+          "volware_updates_applied_total", "Channel values applied")),
+      m_latencyMetric(MetricsRegistry::global().histogram(
+          "volware_apply_latency_seconds",
+          "Time from receiving a channel value to its backend calls "
+          "returning",
+          APPLY_LATENCY_BOUNDS_US)) {}
+
+VolumeApplier::~VolumeApplier() { stop(); }
+
+void VolumeApplier::start() {
+    if (m_running) {
+        return;
+    }
+
+    m_running = true;
+    m_pending.fetch_and(~STOP_BIT);
+    m_workerThread = std::jthread(&VolumeApplier::workerThread, this);
+}
+
+void VolumeApplier::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    m_running = false;
+    m_pending.fetch_or(STOP_BIT);
+    m_pending.notify_one();
+    if (m_workerThread.joinable()) {
+        m_workerThread.join();
+    }
+}
+
+std::uint32_t VolumeApplier::nowUs() {
+    // Same clock as the latency tracer, so receive times can be passed in
+    return static_cast<std::uint32_t>(LatencyTracer::nowUs());
+}
+
+std::uint64_t VolumeApplier::packSlot(int value, int mute,
+                                      std::uint32_t timeUs) {
+    std::uint64_t slot = static_cast<std::uint16_t>(value);
+    if (mute != NO_MUTE) {
+        slot |= (mute ? 1ull : 0ull) << 16 | 1ull << 17;
+    }
+    return slot | static_cast<std::uint64_t>(timeUs) << 32;
+}
+
+void VolumeApplier::post(int channel, int value, int mute,
+                         std::uint64_t receivedUs) {
+    if (channel < 0 || channel >= MAX_CHANNELS) {
+        return;
+    }
+
+    // Publish the value, then flag the channel; a flag that is still set
+    // means the previous value was never applied
+    std::uint32_t timeUs =
+        receivedUs ? static_cast<std::uint32_t>(receivedUs) : nowUs();
+    std::uint64_t slot = packSlot(value, mute, timeUs);
+    if (mute == NO_MUTE) {
+        // Carry the last mute state over instead of dropping it
+        std::uint64_t previous =
+            m_slots[channel].load(std::memory_order_relaxed);
+        while (!m_slots[channel].compare_exchange_weak(
+            previous, slot | (previous & SLOT_MUTE_BITS),
+            std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    } else {
+        m_slots[channel].store(slot, std::memory_order_release);
+    }
+    std::uint32_t bit = 1u << channel;
+    std::uint32_t previous = m_pending.fetch_or(bit, std::memory_order_acq_rel);
+
+    m_updatesPosted.fetch_add(1, std::memory_order_relaxed);
+    if (previous & bit) {
+        m_updatesCoalesced.fetch_add(1, std::memory_order_relaxed);
+        m_coalescedMetric.add();
+    } else {
+        m_pending.notify_one();
+    }
+}
+
+void VolumeApplier::workerThread() {
+    while (true) {
+        // Sleep until a channel is flagged, wake() is called or shutdown is
+        // requested
+        m_pending.wait(0, std::memory_order_acquire);
+        std::uint32_t pending =
+            m_pending.exchange(0, std::memory_order_acq_rel);
+        if (pending & STOP_BIT) {
+            break;
+        }
+        pending &= ~WAKE_BIT;
+
+        // Take every pending channel into one batch
+        std::array<Update, MAX_CHANNELS> batch;
+        std::array<std::uint32_t, MAX_CHANNELS> slotTimes;
+        std::size_t count = 0;
+        while (pending) {
+            int channel = std::countr_zero(pending);
+            pending &= pending - 1;
+
+            std::uint64_t slot =
+                m_slots[channel].load(std::memory_order_acquire);
+            int value = static_cast<std::uint16_t>(slot);
+            int mute = (slot & 1ull << 17) ? static_cast<int>(slot >> 16 & 1)
+                                           : NO_MUTE;
+            batch[count] = {channel, value, mute};
+            slotTimes[count] = static_cast<std::uint32_t>(slot >> 32);
+            count++;
+        }
+
+        std::uint32_t applyStartUs = nowUs();
+        m_apply(std::span<const Update>(batch.data(), count));
+        std::uint64_t endUs = LatencyTracer::nowUs();
+
+        LatencyTracer &tracer = LatencyTracer::global();
+        for (std::size_t i = 0; i < count; i++) {
+            // Latency from receive to the backend calls returning
+            std::uint64_t latencyUs = static_cast<std::uint32_t>(
+                static_cast<std::uint32_t>(endUs) - slotTimes[i]);
+
+            if (tracer.isEnabled()) {
+                // Widen the truncated slot time back onto the full clock
+                std::uint64_t receivedUs = endUs - latencyUs;
+                tracer.record(LatencyTracer::Stage::Queue, receivedUs,
+                              receivedUs + static_cast<std::uint32_t>(
+                                               applyStartUs - slotTimes[i]));
+                tracer.record(LatencyTracer::Stage::EndToEnd, receivedUs,
+                              endUs);
+            }
+
+            m_latencyMetric.record(latencyUs);
+            m_applyLatencyTotalUs.fetch_add(latencyUs,
+                                            std::memory_order_relaxed);
+            std::uint64_t maxUs =
+                m_applyLatencyMaxUs.load(std::memory_order_relaxed);
+            while (latencyUs > maxUs &&
+                   !m_applyLatencyMaxUs.compare_exchange_weak(maxUs,
+                                                              latencyUs)) {
+            }
+        }
+        m_updatesApplied.fetch_add(count, std::memory_order_relaxed);
+        m_appliedMetric.add(count);
+    }
+}
+
+VolumeApplier::Stats VolumeApplier::getStats() const {
+    return {m_framesReceived, m_updatesPosted, m_updatesCoalesced,
+            m_updatesApplied, m_applyLatencyTotalUs, m_applyLatencyMaxUs};
+}
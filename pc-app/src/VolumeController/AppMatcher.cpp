@@ -0,0 +1,132 @@
+#include "AppMatcher.h"
+
+#include <algorithm>
+
+namespace {
+
+// Compare a segment that may contain '?' against text of the same length
+bool segmentMatches(std::string_view segment, std::string_view text) {
+    for (std::size_t i = 0; i < segment.size(); i++) {
+        if (segment[i] != '?' && segment[i] != text[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Position of the first match of segment in text at or after from
+std::size_t findSegment(std::string_view text, std::string_view segment,
+                        std::size_t from) {
+    if (segment.find('?') == std::string_view::npos) {
+        return text.find(segment, from);
+    }
+    for (std::size_t i = from; i + segment.size() <= text.size(); i++) {
+        if (segmentMatches(segment, text.substr(i, segment.size()))) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+} // namespace
+
+AppMatcher::Glob::Glob(std::string_view pattern) {
+    std::size_t start = 0;
+    while (true) {
+        std::size_t star = pattern.find('*', start);
+        std::string_view segment = pattern.substr(
+            start, star == std::string_view::npos ? star : star - start);
+        segments.emplace_back(segment);
+        literalLength += segment.size() -
+                         std::count(segment.begin(), segment.end(), '?');
+        if (star == std::string_view::npos) {
+            break;
+        }
+        start = star + 1;
+    }
+}
+
+bool AppMatcher::Glob::matches(std::string_view name) const {
+    // Without a '*' the name must match the single segment in full
+    const std::string &first = segments.front();
+    if (segments.size() == 1) {
+        return name.size() == first.size() && segmentMatches(first, name);
+    }
+
+    // Otherwise the first segment anchors the start, the last one the end,
+    // and the ones in between are found left to right, which is never worse
+    // than any other placement
+    const std::string &last = segments.back();
+    if (name.size() < first.size() + last.size() ||
+        !segmentMatches(first, name.substr(0, first.size())) ||
+        !segmentMatches(last, name.substr(name.size() - last.size()))) {
+        return false;
+    }
+
+    std::string_view middle =
+        name.substr(first.size(), name.size() - first.size() - last.size());
+    std::size_t position = 0;
+    for (std::size_t i = 1; i + 1 < segments.size(); i++) {
+        position = findSegment(middle, segments[i], position);
+        if (position == std::string_view::npos) {
+            return false;
+        }
+        position += segments[i].size();
+    }
+    return true;
+}
+
+AppMatcher::AppMatcher(std::span<const TargetPatterns> targets)
+    : m_targetCount(targets.size()), m_exclusions(targets.size()) {
+    for (std::size_t i = 0; i < targets.size(); i++) {
+        TargetId target = static_cast<TargetId>(i);
+        if (targets[i].unmapped) {
+            m_unmappedTarget = target;
+        } else if (isGlob(targets[i].pattern)) {
+            m_globTargets.push_back({Glob(targets[i].pattern), target});
+        } else {
+            m_exactTargets.try_emplace(targets[i].pattern, target);
+        }
+        for (const std::string &exclusion : targets[i].exclusions) {
+            m_exclusions[i].emplace_back(exclusion);
+        }
+    }
+
+    // Ties keep the order of the targets
+    std::stable_sort(m_globTargets.begin(), m_globTargets.end(),
+                     [](const GlobTarget &a, const GlobTarget &b) {
+                         return a.glob.literalLength > b.glob.literalLength;
+                     });
+}
+
+AppMatcher::TargetId
+AppMatcher::match(std::string_view processNameLower) const {
+    auto it = m_exactTargets.find(std::string(processNameLower));
+    if (it != m_exactTargets.end() &&
+        !isExcluded(it->second, processNameLower)) {
+        return it->second;
+    }
+
+    for (const GlobTarget &glob : m_globTargets) {
+        if (glob.glob.matches(processNameLower) &&
+            !isExcluded(glob.target, processNameLower)) {
+            return glob.target;
+        }
+    }
+
+    if (m_unmappedTarget != NO_TARGET &&
+        !isExcluded(m_unmappedTarget, processNameLower)) {
+        return m_unmappedTarget;
+    }
+    return NO_TARGET;
+}
+
+bool AppMatcher::isGlob(std::string_view pattern) {
+    return pattern.find_first_of("*?") != std::string_view::npos;
+}
+
+bool AppMatcher::isExcluded(TargetId target, std::string_view name) const {
+    const std::vector<Glob> &exclusions = m_exclusions[target];
+    return std::any_of(exclusions.begin(), exclusions.end(),
+                       [name](const Glob &glob) { return glob.matches(name); });
+}
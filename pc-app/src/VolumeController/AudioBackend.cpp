@@ -0,0 +1,27 @@
+#include "AudioBackend.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include "WindowsAudioBackend.h"
+#elif defined(__linux__) && defined(HAVE_PULSEAUDIO)
+#include "PulseAudioBackend.h"
+#elif defined(__linux__)
+#include "SimulatedAudioBackend.h"
+#include <iostream>
+#elif defined(__APPLE__)
+#error "macOS implementation not available yet"
+#else
+#error "Unsupported platform"
+#endif
+
+std::unique_ptr<AudioBackend> createDefaultAudioBackend() {
+#if defined(_WIN32) || defined(_WIN64)
+    return std::make_unique<WindowsAudioBackend>();
+#elif defined(HAVE_PULSEAUDIO)
+    return std::make_unique<PulseAudioBackend>();
+#else
+    // Built without libpulse, run the volume path against the simulation
+    std::cerr << "No native audio backend, using simulated backend."
+              << std::endl;
+    return std::make_unique<SimulatedAudioBackend>();
+#endif
+}
@@ -0,0 +1,266 @@
+#include "ProcessNameCache.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#elif defined(__linux__)
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <limits.h>
+#include <string_view>
+#include <unistd.h>
+#endif
+
+#include <iterator>
+
+namespace {
+
+const char *const UNKNOWN_NAME = "<unknown>";
+
+#if defined(_WIN32) || defined(_WIN64)
+
+std::string wideToUtf8(const wchar_t *wstr) {
+    int size = WideCharToMultiByte(CP_UTF8, 0, wstr, -1, nullptr, 0, nullptr,
+                                   nullptr);
+    if (size <= 1) {
+        return {};
+    }
+    std::string result(size - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wstr, -1, result.data(), size, nullptr,
+                        nullptr);
+    return result;
+}
+
+#elif defined(__linux__)
+
+// Large enough for /proc/<pid>/stat up to the start time, field 22
+constexpr std::size_t STAT_BUFFER_SIZE = 1024;
+
+// "/proc/<pid>/<file>" in a caller's buffer, without allocating
+const char *procPath(char (&path)[64], ProcessNameCache::ProcessId processId,
+                     const char *file) {
+    char *end = path + sizeof(path) - 1;
+    char *p = path + std::strlen(std::strcpy(path, "/proc/"));
+    p = std::to_chars(p, end, processId).ptr;
+    *p++ = '/';
+    std::size_t length = std::min(std::strlen(file),
+                                  static_cast<std::size_t>(end - p));
+    std::memcpy(p, file, length);
+    p[length] = '\0';
+    return path;
+}
+
+// Process name and start time from /proc/<pid>/stat, read into a stack
+// buffer; comm points into it. The name is the kernel's comm, cut to 15
+// characters, and sits in parentheses that may themselves contain spaces
+// and parentheses.
+bool readProcessStat(ProcessNameCache::ProcessId processId,
+                     char (&buffer)[STAT_BUFFER_SIZE], std::string_view &comm,
+                     std::uint64_t &startTime) {
+    char path[64];
+    int fd = open(procPath(path, processId, "stat"), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t length = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+
+    std::string_view stat(buffer, static_cast<std::size_t>(length));
+    std::size_t nameStart = stat.find('(');
+    std::size_t nameEnd = stat.rfind(')');
+    if (nameStart == std::string_view::npos ||
+        nameEnd == std::string_view::npos || nameEnd < nameStart) {
+        return false;
+    }
+    comm = stat.substr(nameStart + 1, nameEnd - nameStart - 1);
+
+    // Fields after the name start with the state, field 3 of proc(5);
+    // starttime is field 22
+    const char *p = stat.data() + nameEnd + 1;
+    const char *end = stat.data() + stat.size();
+    for (int i = 3; i < 22; i++) {
+        while (p < end && *p == ' ') {
+            p++;
+        }
+        while (p < end && *p != ' ') {
+            p++;
+        }
+    }
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    auto [fieldEnd, error] = std::from_chars(p, end, startTime);
+    return error == std::errc() && fieldEnd != p;
+}
+
+// Executable name from the /proc/<pid>/exe link, which is only readable
+// for our own processes unless we are privileged
+std::string readExecutableName(ProcessNameCache::ProcessId processId) {
+    char link[64];
+    char path[PATH_MAX];
+    ssize_t length =
+        readlink(procPath(link, processId, "exe"), path, sizeof(path));
+    if (length <= 0 || length == static_cast<ssize_t>(sizeof(path))) {
+        return {};
+    }
+
+    std::string_view target(path, length);
+    constexpr std::string_view DELETED = " (deleted)";
+    if (target.ends_with(DELETED)) {
+        target.remove_suffix(DELETED.size());
+    }
+    std::size_t slash = target.rfind('/');
+    return std::string(slash == std::string_view::npos
+                           ? target
+                           : target.substr(slash + 1));
+}
+
+#endif
+
+} // namespace
+
+ProcessNameCache::ProcessNameCache(std::size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1),
+      m_hitMetric(MetricsRegistry::global().counter(
+          "volware_process_name_cache_hits_total",
+          "Process names found in the cache")),
+      m_missMetric(MetricsRegistry::global().counter(
+          "volware_process_name_cache_misses_total",
+          "Process names that had to be queried")),
+      m_evictionMetric(MetricsRegistry::global().counter(
+          "volware_process_name_cache_evictions_total",
+          "Process names dropped to make room")) {
+    m_index.reserve(m_capacity);
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+std::string ProcessNameCache::resolve(ProcessId processId) {
+    // Limited access suffices for both queries and is also granted for
+    // elevated processes
+    HANDLE process =
+        OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+    if (!process) {
+        return UNKNOWN_NAME;
+    }
+
+    std::string name = UNKNOWN_NAME;
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(process, &creation, &exit, &kernel, &user)) {
+        std::uint64_t startTime =
+            (static_cast<std::uint64_t>(creation.dwHighDateTime) << 32) |
+            creation.dwLowDateTime;
+        if (!find(processId, startTime, name)) {
+            WCHAR path[MAX_PATH] = {0};
+            DWORD size = MAX_PATH;
+            if (QueryFullProcessImageNameW(process, 0, path, &size)) {
+                const WCHAR *fileName = wcsrchr(path, L'\\');
+                std::string utf8 = wideToUtf8(fileName ? fileName + 1 : path);
+                if (!utf8.empty()) {
+                    name = utf8;
+                    insert(processId, startTime, name);
+                }
+            }
+        }
+    }
+    CloseHandle(process);
+    return name;
+}
+
+#elif defined(__linux__)
+
+std::string ProcessNameCache::resolve(ProcessId processId) {
+    char stat[STAT_BUFFER_SIZE];
+    std::string_view comm;
+    std::uint64_t startTime = 0;
+    if (!readProcessStat(processId, stat, comm, startTime)) {
+        return UNKNOWN_NAME;
+    }
+
+    std::string name;
+    if (find(processId, startTime, name)) {
+        return name;
+    }
+
+    // Other users' executables are hidden, their comm is not
+    name = readExecutableName(processId);
+    if (name.empty()) {
+        name.assign(comm);
+    }
+    if (name.empty()) {
+        return UNKNOWN_NAME;
+    }
+    insert(processId, startTime, name);
+    return name;
+}
+
+#else
+
+std::string ProcessNameCache::resolve(ProcessId) { return UNKNOWN_NAME; }
+
+#endif
+
+bool ProcessNameCache::find(ProcessId processId, std::uint64_t startTime,
+                            std::string &name) {
+    {
+        // Hits only mark the entry, so lookups share the lock
+        std::shared_lock<std::shared_mutex> lock(m_mtx);
+        auto it = m_index.find({processId, startTime});
+        if (it != m_index.end()) {
+            it->second->referenced.store(true, std::memory_order_relaxed);
+            name = it->second->name;
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            m_hitMetric.add();
+            return true;
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    m_missMetric.add();
+    return false;
+}
+
+void ProcessNameCache::insert(ProcessId processId, std::uint64_t startTime,
+                              std::string name) {
+    Key key{processId, startTime};
+    std::unique_lock<std::shared_mutex> lock(m_mtx);
+
+    // Another thread may have resolved the same process meanwhile
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->name = std::move(name);
+        it->second->referenced.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    if (m_entries.size() >= m_capacity) {
+        // Second chance: entries hit since they were last passed over move
+        // to the front instead, so the oldest unused entry goes. A full
+        // round clears every mark, which bounds the loop.
+        while (m_entries.back().referenced.exchange(
+            false, std::memory_order_relaxed)) {
+            m_entries.splice(m_entries.begin(), m_entries,
+                             std::prev(m_entries.end()));
+        }
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+        m_evictionMetric.add();
+    }
+    m_entries.emplace_front(key, std::move(name));
+    m_index.emplace(key, m_entries.begin());
+}
+
+ProcessNameCache::Stats ProcessNameCache::getStats() const {
+    std::size_t size;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mtx);
+        size = m_entries.size();
+    }
+    return {m_hits.load(std::memory_order_relaxed),
+            m_misses.load(std::memory_order_relaxed),
+            m_evictions.load(std::memory_order_relaxed), size};
+}
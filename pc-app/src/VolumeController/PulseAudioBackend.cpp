@@ -0,0 +1,340 @@
+#include "PulseAudioBackend.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// Name that always refers to the server's current default sink
+constexpr const char *DEFAULT_SINK = "@DEFAULT_SINK@";
+
+// Volume as shown by mixers such as pavucontrol, 1.0 being 100%
+pa_cvolume makeVolume(uint8_t channels, float volumeLevel) {
+    pa_cvolume volume;
+    pa_cvolume_set(&volume, std::max<uint8_t>(channels, 1),
+                   static_cast<pa_volume_t>(volumeLevel * PA_VOLUME_NORM));
+    return volume;
+}
+
+float volumeLevel(const pa_cvolume &volume) {
+    return static_cast<float>(pa_cvolume_max(&volume)) / PA_VOLUME_NORM;
+}
+
+} // namespace
+
+PulseAudioBackend::PulseAudioBackend() {
+    m_mainloop = pa_threaded_mainloop_new();
+    if (!m_mainloop) {
+        throw std::runtime_error("Failed to create PulseAudio mainloop.");
+    }
+
+    m_context = pa_context_new(pa_threaded_mainloop_get_api(m_mainloop),
+                               "VolWare");
+    if (!m_context) {
+        pa_threaded_mainloop_free(m_mainloop);
+        throw std::runtime_error("Failed to create PulseAudio context.");
+    }
+    pa_context_set_state_callback(m_context, contextStateCallback, this);
+
+    pa_threaded_mainloop_lock(m_mainloop);
+    bool connected =
+        pa_context_connect(m_context, nullptr, PA_CONTEXT_NOFLAGS, nullptr) >=
+            0 &&
+        pa_threaded_mainloop_start(m_mainloop) >= 0;
+
+    // Wait until the context is ready or has failed
+    while (connected) {
+        pa_context_state_t state = pa_context_get_state(m_context);
+        if (state == PA_CONTEXT_READY) {
+            break;
+        }
+        if (!PA_CONTEXT_IS_GOOD(state)) {
+            connected = false;
+            break;
+        }
+        pa_threaded_mainloop_wait(m_mainloop);
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+
+    if (!connected) {
+        pa_threaded_mainloop_stop(m_mainloop);
+        pa_context_unref(m_context);
+        pa_threaded_mainloop_free(m_mainloop);
+        throw std::runtime_error("Failed to connect to PulseAudio server.");
+    }
+}
+
+PulseAudioBackend::~PulseAudioBackend() {
+    pa_threaded_mainloop_lock(m_mainloop);
+    pa_context_set_subscribe_callback(m_context, nullptr, nullptr);
+    pa_context_set_state_callback(m_context, nullptr, nullptr);
+    pa_context_disconnect(m_context);
+    pa_context_unref(m_context);
+    pa_threaded_mainloop_unlock(m_mainloop);
+
+    pa_threaded_mainloop_stop(m_mainloop);
+    pa_threaded_mainloop_free(m_mainloop);
+}
+
+void PulseAudioBackend::EndpointState::recordVolume(pa_volume_t volume) {
+    m_writes[m_nextWrite] = {volume, -1, Clock::now()};
+    m_nextWrite = (m_nextWrite + 1) % m_writes.size();
+}
+
+void PulseAudioBackend::EndpointState::recordMute(bool mute) {
+    m_writes[m_nextWrite] = {PA_VOLUME_INVALID, mute, Clock::now()};
+    m_nextWrite = (m_nextWrite + 1) % m_writes.size();
+}
+
+bool PulseAudioBackend::EndpointState::isRecentWrite(
+    pa_volume_t volume, int mute, Clock::time_point now) const {
+    return std::any_of(m_writes.begin(), m_writes.end(),
+                       [&](const Write &write) {
+                           return write.volume == volume &&
+                                  write.mute == mute &&
+                                  now - write.time < std::chrono::milliseconds(
+                                                         WRITE_ECHO_MS);
+                       });
+}
+
+bool PulseAudioBackend::EndpointState::update(const pa_cvolume &volume,
+                                              bool mute) {
+    // A value that is unchanged or that we have written is no change of
+    // another program; replies to later queries may skip values, so every
+    // recent write is a candidate, not only the last one
+    Clock::time_point now = Clock::now();
+    pa_volume_t newVolume = pa_cvolume_max(&volume);
+    int newMute = mute;
+    bool volumeChanged =
+        newVolume != m_volume && !isRecentWrite(newVolume, -1, now);
+    bool muteChanged = newMute != m_mute &&
+                       !isRecentWrite(PA_VOLUME_INVALID, newMute, now);
+    m_volume = newVolume;
+    m_mute = newMute;
+    return volumeChanged || muteChanged;
+}
+
+void PulseAudioBackend::contextStateCallback(pa_context *, void *userdata) {
+    auto *self = static_cast<PulseAudioBackend *>(userdata);
+    pa_threaded_mainloop_signal(self->m_mainloop, 0);
+}
+
+bool PulseAudioBackend::waitForOperation(pa_operation *operation) {
+    if (!operation) {
+        return false;
+    }
+    while (pa_operation_get_state(operation) == PA_OPERATION_RUNNING) {
+        pa_threaded_mainloop_wait(m_mainloop);
+    }
+    pa_operation_unref(operation);
+    return true;
+}
+
+bool PulseAudioBackend::start(Listener &listener) {
+    pa_threaded_mainloop_lock(m_mainloop);
+    m_listener = &listener;
+
+    // Subscribe before listing so no sink-input is missed; duplicates are
+    // filtered by index
+    pa_context_set_subscribe_callback(m_context, subscribeCallback, this);
+    bool started = waitForOperation(pa_context_subscribe(
+        m_context,
+        static_cast<pa_subscription_mask_t>(PA_SUBSCRIPTION_MASK_SINK_INPUT |
+                                            PA_SUBSCRIPTION_MASK_SINK |
+                                            PA_SUBSCRIPTION_MASK_SERVER),
+        [](pa_context *, int, void *userdata) {
+            auto *self = static_cast<PulseAudioBackend *>(userdata);
+            pa_threaded_mainloop_signal(self->m_mainloop, 0);
+        },
+        this));
+
+    started = started &&
+              waitForOperation(pa_context_get_sink_input_info_list(
+                  m_context, sinkInputInfoCallback, this)) &&
+              waitForOperation(pa_context_get_sink_info_by_name(
+                  m_context, DEFAULT_SINK, sinkInfoCallback, this));
+
+    pa_threaded_mainloop_unlock(m_mainloop);
+    return started;
+}
+
+void PulseAudioBackend::subscribeCallback(pa_context *context,
+                                          pa_subscription_event_type_t type,
+                                          uint32_t index, void *userdata) {
+    auto *self = static_cast<PulseAudioBackend *>(userdata);
+    unsigned facility = type & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+    unsigned event = type & PA_SUBSCRIPTION_EVENT_TYPE_MASK;
+
+    if (facility == PA_SUBSCRIPTION_EVENT_SERVER ||
+        (facility == PA_SUBSCRIPTION_EVENT_SINK &&
+         event == PA_SUBSCRIPTION_EVENT_CHANGE && index == self->m_sinkIndex)) {
+        // The default sink, or its volume, may have changed
+        self->queryDefaultSink();
+        return;
+    }
+    if (facility != PA_SUBSCRIPTION_EVENT_SINK_INPUT) {
+        return;
+    }
+
+    // Changed sink-inputs are queried again to report their volume
+    if (event == PA_SUBSCRIPTION_EVENT_NEW ||
+        event == PA_SUBSCRIPTION_EVENT_CHANGE) {
+        pa_operation *operation = pa_context_get_sink_input_info(
+            context, index, sinkInputInfoCallback, self);
+        if (operation) {
+            pa_operation_unref(operation);
+        }
+    } else if (event == PA_SUBSCRIPTION_EVENT_REMOVE) {
+        if (self->m_sinkInputs.erase(index) > 0) {
+            self->m_listener->onSessionRemoved(index);
+        }
+    }
+}
+
+void PulseAudioBackend::sinkInputInfoCallback(pa_context *,
+                                              const pa_sink_input_info *info,
+                                              int eol, void *userdata) {
+    auto *self = static_cast<PulseAudioBackend *>(userdata);
+    if (eol) {
+        pa_threaded_mainloop_signal(self->m_mainloop, 0);
+        return;
+    }
+    if (!info) {
+        return;
+    }
+
+    // Known sink-inputs are reported when another program has changed
+    // their volume or mute
+    auto it = self->m_sinkInputs.find(info->index);
+    if (it != self->m_sinkInputs.end()) {
+        if (it->second.state.update(info->volume, info->mute != 0)) {
+            self->m_listener->onSessionVolumeChanged(
+                info->index, volumeLevel(info->volume), info->mute != 0);
+        }
+        return;
+    }
+
+    // Match applications by executable name, like on Windows
+    const char *binary =
+        pa_proplist_gets(info->proplist, PA_PROP_APPLICATION_PROCESS_BINARY);
+    const char *pidText =
+        pa_proplist_gets(info->proplist, PA_PROP_APPLICATION_PROCESS_ID);
+
+    uint32_t processId = 0;
+    if (pidText) {
+        std::from_chars(pidText, pidText + std::strlen(pidText), processId);
+    }
+
+    // The PID is the client's own claim and, for sandboxed clients, may be
+    // from another PID namespace, so it only stands in for a missing name
+    std::string processName;
+    if (binary) {
+        processName = binary;
+    } else if (processId != 0) {
+        processName = self->m_processNames.resolve(processId);
+    } else {
+        processName = "<unknown>";
+    }
+
+    SinkInput &sinkInput = self->m_sinkInputs[info->index];
+    sinkInput.channels = info->channel_map.channels;
+    sinkInput.state.update(info->volume, info->mute != 0);
+    self->m_listener->onSessionAdded({info->index, processId, processName});
+}
+
+void PulseAudioBackend::sinkInfoCallback(pa_context *, const pa_sink_info *info,
+                                         int eol, void *userdata) {
+    auto *self = static_cast<PulseAudioBackend *>(userdata);
+    if (eol) {
+        pa_threaded_mainloop_signal(self->m_mainloop, 0);
+        return;
+    }
+    if (info) {
+        // Writes to the previous default sink say nothing about this one
+        if (info->index != self->m_sinkIndex) {
+            self->m_sinkState = {};
+        }
+        self->m_sinkIndex = info->index;
+        self->m_sinkChannels = info->channel_map.channels;
+        if (self->m_sinkState.update(info->volume, info->mute != 0)) {
+            self->m_listener->onMasterVolumeChanged(volumeLevel(info->volume),
+                                                    info->mute != 0);
+        }
+    }
+}
+
+void PulseAudioBackend::queryDefaultSink() {
+    pa_operation *operation = pa_context_get_sink_info_by_name(
+        m_context, DEFAULT_SINK, sinkInfoCallback, this);
+    if (operation) {
+        pa_operation_unref(operation);
+    }
+}
+
+bool PulseAudioBackend::setMasterVolume(float volumeLevel) {
+    pa_threaded_mainloop_lock(m_mainloop);
+    pa_cvolume volume = makeVolume(m_sinkChannels, volumeLevel);
+    pa_operation *operation = pa_context_set_sink_volume_by_name(
+        m_context, DEFAULT_SINK, &volume, nullptr, nullptr);
+    if (operation) {
+        m_sinkState.recordVolume(pa_cvolume_max(&volume));
+        pa_operation_unref(operation);
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+    return operation != nullptr;
+}
+
+bool PulseAudioBackend::setMasterMute(bool mute) {
+    pa_threaded_mainloop_lock(m_mainloop);
+    pa_operation *operation = pa_context_set_sink_mute_by_name(
+        m_context, DEFAULT_SINK, mute, nullptr, nullptr);
+    if (operation) {
+        m_sinkState.recordMute(mute);
+        pa_operation_unref(operation);
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+    return operation != nullptr;
+}
+
+bool PulseAudioBackend::setSessionVolume(SessionId sessionId,
+                                         float volumeLevel) {
+    pa_threaded_mainloop_lock(m_mainloop);
+
+    // Sink-inputs that disappeared in the meantime are simply skipped
+    auto it = m_sinkInputs.find(static_cast<uint32_t>(sessionId));
+    if (it == m_sinkInputs.end()) {
+        pa_threaded_mainloop_unlock(m_mainloop);
+        return true;
+    }
+
+    pa_cvolume volume = makeVolume(it->second.channels, volumeLevel);
+    pa_operation *operation = pa_context_set_sink_input_volume(
+        m_context, it->first, &volume, nullptr, nullptr);
+    if (operation) {
+        it->second.state.recordVolume(pa_cvolume_max(&volume));
+        pa_operation_unref(operation);
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+    return operation != nullptr;
+}
+
+bool PulseAudioBackend::setSessionMute(SessionId sessionId, bool mute) {
+    pa_threaded_mainloop_lock(m_mainloop);
+
+    auto it = m_sinkInputs.find(static_cast<uint32_t>(sessionId));
+    if (it == m_sinkInputs.end()) {
+        pa_threaded_mainloop_unlock(m_mainloop);
+        return true;
+    }
+
+    pa_operation *operation = pa_context_set_sink_input_mute(
+        m_context, it->first, mute, nullptr, nullptr);
+    if (operation) {
+        it->second.state.recordMute(mute);
+        pa_operation_unref(operation);
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+    return operation != nullptr;
+}
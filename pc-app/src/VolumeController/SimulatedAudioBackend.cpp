@@ -0,0 +1,155 @@
+#include "SimulatedAudioBackend.h"
+
+#include <thread>
+
+bool SimulatedAudioBackend::start(Listener &listener) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_listener = &listener;
+
+    // Report sessions added before the backend was started
+    for (const auto &[sessionId, session] : m_sessions) {
+        m_listener->onSessionAdded(
+            {sessionId, session.processId, session.processName});
+    }
+    return true;
+}
+
+void SimulatedAudioBackend::simulateLatency() const {
+    auto latency = m_callLatency.load();
+    if (latency.count() == 0) {
+        return;
+    }
+
+    // Spin rather than sleep so short latencies are modelled accurately
+    auto deadline = std::chrono::steady_clock::now() + latency;
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+bool SimulatedAudioBackend::setMasterVolume(float volumeLevel) {
+    m_masterVolumeCalls++;
+    simulateLatency();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_masterVolume = volumeLevel;
+    return true;
+}
+
+bool SimulatedAudioBackend::setMasterMute(bool mute) {
+    m_masterMuteCalls++;
+    simulateLatency();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_masterMute = mute;
+    return true;
+}
+
+bool SimulatedAudioBackend::setSessionVolume(SessionId sessionId,
+                                             float volumeLevel) {
+    m_sessionVolumeCalls++;
+    simulateLatency();
+
+    // Sessions that disappeared in the meantime are skipped
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(sessionId);
+    if (it != m_sessions.end()) {
+        it->second.volume = volumeLevel;
+    }
+    return true;
+}
+
+bool SimulatedAudioBackend::setSessionMute(SessionId sessionId, bool mute) {
+    m_sessionMuteCalls++;
+    simulateLatency();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(sessionId);
+    if (it != m_sessions.end()) {
+        it->second.mute = mute;
+    }
+    return true;
+}
+
+AudioBackend::SessionId
+SimulatedAudioBackend::addSession(std::uint32_t processId,
+                                  const std::string &processName) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SessionId sessionId = m_nextSessionId++;
+    m_sessions[sessionId] = {processId, processName};
+
+    if (m_listener) {
+        m_listener->onSessionAdded({sessionId, processId, processName});
+    }
+    return sessionId;
+}
+
+bool SimulatedAudioBackend::removeSession(SessionId sessionId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_sessions.erase(sessionId) == 0) {
+        return false;
+    }
+
+    if (m_listener) {
+        m_listener->onSessionRemoved(sessionId);
+    }
+    return true;
+}
+
+bool SimulatedAudioBackend::changeSessionVolume(SessionId sessionId,
+                                                float volumeLevel, bool mute) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(sessionId);
+    if (it == m_sessions.end()) {
+        return false;
+    }
+
+    it->second.volume = volumeLevel;
+    it->second.mute = mute;
+    if (m_listener) {
+        m_listener->onSessionVolumeChanged(sessionId, volumeLevel, mute);
+    }
+    return true;
+}
+
+void SimulatedAudioBackend::changeMasterVolume(float volumeLevel, bool mute) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_masterVolume = volumeLevel;
+    m_masterMute = mute;
+    if (m_listener) {
+        m_listener->onMasterVolumeChanged(volumeLevel, mute);
+    }
+}
+
+float SimulatedAudioBackend::getMasterVolume() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_masterVolume;
+}
+
+bool SimulatedAudioBackend::getMasterMute() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_masterMute;
+}
+
+std::optional<SimulatedAudioBackend::SessionState>
+SimulatedAudioBackend::getSession(SessionId sessionId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_sessions.find(sessionId);
+    if (it == m_sessions.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+SimulatedAudioBackend::CallCounts
+SimulatedAudioBackend::getCallCounts() const {
+    return {m_masterVolumeCalls, m_masterMuteCalls, m_sessionVolumeCalls,
+            m_sessionMuteCalls};
+}
+
+void SimulatedAudioBackend::resetCallCounts() {
+    m_masterVolumeCalls = 0;
+    m_masterMuteCalls = 0;
+    m_sessionVolumeCalls = 0;
+    m_sessionMuteCalls = 0;
+}
@@ -1,17 +1,12 @@
 #include "VolumeController.h"
+#include "VolumeControllerImpl.h"
 
-#if defined(_WIN32) || defined(_WIN64)
-#include "VolumeControllerImpl_Windows.h"
-#elif defined(__linux__)
-#error "Linux implementation not available yet"
-#elif defined(__APPLE__)
-#error "macOS implementation not available yet"
-#else
-#error "Unsupported platform"
-#endif
+// Constructors
+VolumeController::VolumeController()
+    : pImpl(std::make_unique<Impl>(createDefaultAudioBackend())) {}
 
-// Constructor
-VolumeController::VolumeController() : pImpl(std::make_unique<Impl>()) {}
+VolumeController::VolumeController(std::unique_ptr<AudioBackend> backend)
+    : pImpl(std::make_unique<Impl>(std::move(backend))) {}
 
 // Destructor
 VolumeController::~VolumeController() = default;
@@ -49,3 +44,21 @@ bool VolumeController::setMute(const std::vector<std::string> &processNames,
                                int mute) {
     return pImpl->setMute(processNames, mute);
 }
+
+// Batch control
+void VolumeController::setTargets(const AppMatcher &matcher) {
+    pImpl->setTargets(matcher);
+}
+
+bool VolumeController::applyFrame(std::span<const ChannelUpdate> updates) {
+    return pImpl->applyFrame(updates);
+}
+
+void VolumeController::setExternalChangeCallbacks(
+    ExternalChangeCallback callback, std::function<void()> notify) {
+    pImpl->setExternalChangeCallbacks(std::move(callback), std::move(notify));
+}
+
+VolumeController::Stats VolumeController::getStats() const {
+    return pImpl->getStats();
+}
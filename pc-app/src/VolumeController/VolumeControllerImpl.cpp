@@ -0,0 +1,450 @@
+#include "VolumeControllerImpl.h"
+
+#include "LatencyTracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Bucket bounds of the backend call histogram
+constexpr std::uint64_t BACKEND_CALL_BOUNDS_US[] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+
+// Run one backend call, timing it for the metrics and, when enabled, for
+// the latency trace
+template <typename Call>
+bool tracedBackendCall(Call call, MetricHistogram &metric) {
+    std::uint64_t startUs = LatencyTracer::nowUs();
+    bool result = call();
+    std::uint64_t endUs = LatencyTracer::nowUs();
+
+    metric.record(endUs - startUs);
+    LatencyTracer &tracer = LatencyTracer::global();
+    if (tracer.isEnabled()) {
+        tracer.record(LatencyTracer::Stage::Backend, startUs, endUs);
+    }
+    return result;
+}
+
+} // namespace
+
+VolumeController::Impl::Impl(std::unique_ptr<AudioBackend> audioBackend)
+    : backendCallMetric(MetricsRegistry::global().histogram(
+          "volware_backend_call_seconds",
+          "Duration of volume and mute calls to the audio backend",
+          BACKEND_CALL_BOUNDS_US)),
+      backendFailureMetric(MetricsRegistry::global().counter(
+          "volware_backend_call_failures_total",
+          "Audio backend calls that failed")),
+      writesSkippedMetric(MetricsRegistry::global().counter(
+          "volware_backend_writes_skipped_total",
+          "Backend calls saved because the value was already applied")),
+      externalChangeMetric(MetricsRegistry::global().counter(
+          "volware_external_changes_total",
+          "Volume and mute changes made by other programs")),
+      backend(std::move(audioBackend)) {
+    if (!backend || !backend->start(*this)) {
+        throw std::runtime_error("Failed to start audio backend.");
+    }
+}
+
+VolumeController::Impl::~Impl() {
+    // Stop notifications before the event queue goes away
+    backend.reset();
+}
+
+void VolumeController::Impl::onSessionAdded(
+    const AudioBackend::SessionInfo &session) {
+    std::lock_guard<std::mutex> lock(eventMtx);
+    pendingEvents.push_back({EventType::Added, session});
+    eventsPending = true;
+    if (notifyExternalChange) {
+        notifyExternalChange();
+    }
+}
+
+void VolumeController::Impl::onSessionRemoved(
+    AudioBackend::SessionId sessionId) {
+    std::lock_guard<std::mutex> lock(eventMtx);
+    pendingEvents.push_back({EventType::Removed, {sessionId, 0, {}}});
+    eventsPending = true;
+}
+
+void VolumeController::Impl::onSessionVolumeChanged(
+    AudioBackend::SessionId sessionId, float volumeLevel, bool mute) {
+    std::lock_guard<std::mutex> lock(eventMtx);
+    pendingEvents.push_back(
+        {EventType::VolumeChanged, {sessionId, 0, {}}, volumeLevel, mute});
+    eventsPending = true;
+    if (notifyExternalChange) {
+        notifyExternalChange();
+    }
+}
+
+void VolumeController::Impl::onMasterVolumeChanged(float volumeLevel,
+                                                   bool mute) {
+    std::lock_guard<std::mutex> lock(eventMtx);
+    pendingEvents.push_back(
+        {EventType::MasterChanged, {0, 0, {}}, volumeLevel, mute});
+    eventsPending = true;
+    if (notifyExternalChange) {
+        notifyExternalChange();
+    }
+}
+
+void VolumeController::Impl::processSessionEvents() {
+    if (!eventsPending) {
+        return;
+    }
+
+    // Take the queued events and apply them outside the queue lock
+    {
+        std::lock_guard<std::mutex> lock(eventMtx);
+        processingEvents.swap(pendingEvents);
+        eventsPending = false;
+    }
+
+    for (const auto &event : processingEvents) {
+        switch (event.type) {
+        case EventType::Added: {
+            // A new session starts at its own volume, so it is always
+            // written once
+            auto it = sessions.find(event.session.id);
+            if (it != sessions.end()) {
+                unassignTarget(it->second);
+                std::erase(addedSessions, &it->second);
+                sessions.erase(it);
+            }
+
+            Session &session = sessions[event.session.id];
+            session.id = event.session.id;
+            session.processNameLower =
+                sessionIndex.toLower(event.session.processName);
+            sessionIndex.add(session.id, session.processNameLower, &session);
+            assignTarget(session);
+            addedSessions.push_back(&session);
+            break;
+        }
+        case EventType::Removed: {
+            auto it = sessions.find(event.session.id);
+            if (it != sessions.end()) {
+                unassignTarget(it->second);
+                std::erase(addedSessions, &it->second);
+                sessionIndex.remove(it->first);
+                sessions.erase(it);
+            }
+            break;
+        }
+        case EventType::VolumeChanged: {
+            auto it = sessions.find(event.session.id);
+            if (it != sessions.end() &&
+                checkAppliedState(it->second.applied, event.volumeLevel,
+                                  event.mute) &&
+                it->second.target != NO_TARGET && externalChangeCallback) {
+                externalChangeCallback({it->second.target, false,
+                                        event.volumeLevel, event.mute});
+            }
+            break;
+        }
+        case EventType::MasterChanged:
+            if (checkAppliedState(masterState, event.volumeLevel,
+                                  event.mute) &&
+                externalChangeCallback) {
+                externalChangeCallback(
+                    {NO_TARGET, true, event.volumeLevel, event.mute});
+            }
+            break;
+        }
+    }
+    processingEvents.clear();
+
+    // Bring new sessions to their channel's volume. This comes after the
+    // whole batch, whose notifications for them predate the write.
+    for (Session *session : addedSessions) {
+        if (session->target == NO_TARGET ||
+            !targetStates[session->target].known) {
+            continue;
+        }
+        const TargetState &state = targetStates[session->target];
+        writeSessionVolume(*session, state.volumeLevel);
+        if (state.mute != NO_MUTE) {
+            writeSessionMute(*session, state.mute);
+        }
+    }
+    addedSessions.clear();
+}
+
+void VolumeController::Impl::assignTarget(Session &session) {
+    session.target = targetMatcher.match(session.processNameLower);
+    if (session.target == NO_TARGET) {
+        return;
+    }
+    targetSessions[session.target].push_back(&session);
+}
+
+void VolumeController::Impl::unassignTarget(Session &session) {
+    if (session.target == NO_TARGET) {
+        return;
+    }
+    std::erase(targetSessions[session.target], &session);
+    session.target = NO_TARGET;
+}
+
+void VolumeController::Impl::setTargets(const AppMatcher &matcher) {
+    std::lock_guard<std::mutex> lock(mtx);
+    processSessionEvents();
+    targetMatcher = matcher;
+
+    // Sort the known sessions into the new targets
+    targetSessions.assign(targetMatcher.targetCount(), {});
+    targetStates.assign(targetMatcher.targetCount(), {});
+    for (auto &[sessionId, session] : sessions) {
+        session.target = NO_TARGET;
+        assignTarget(session);
+    }
+}
+
+int VolumeController::Impl::quantizeVolume(float volumeLevel) {
+    return static_cast<int>(std::lround(volumeLevel * VOLUME_STEPS));
+}
+
+bool VolumeController::Impl::checkAppliedState(AppliedState &state,
+                                               float volumeLevel, bool mute) {
+    // Backends drop the echoes of our own writes: Windows by their event
+    // context, PulseAudio by the values written in the last WRITE_ECHO_MS,
+    // and the simulated backend never reports them. A notification that
+    // still matches the cache is ignored; any other is a change made by
+    // another program, which the cache takes over and the caller reports,
+    // detaching the knob.
+    bool changed = false;
+    if (state.volume != UNKNOWN &&
+        state.volume != quantizeVolume(volumeLevel)) {
+        state.volume = quantizeVolume(volumeLevel);
+        changed = true;
+    }
+    if (state.mute != UNKNOWN && state.mute != static_cast<int>(mute)) {
+        state.mute = mute;
+        changed = true;
+    }
+    if (changed) {
+        externalChanges.fetch_add(1, std::memory_order_relaxed);
+        externalChangeMetric.add();
+    }
+    return changed;
+}
+
+template <typename Write>
+bool VolumeController::Impl::writeIfChanged(int &appliedValue, int value,
+                                            Write write) {
+    if (appliedValue == value) {
+        writesSkipped.fetch_add(1, std::memory_order_relaxed);
+        writesSkippedMetric.add();
+        return true;
+    }
+
+    // A failed write leaves the endpoint unknown, so it is retried
+    bool success = tracedBackendCall(write, backendCallMetric);
+    backendWrites.fetch_add(1, std::memory_order_relaxed);
+    if (!success) {
+        backendFailureMetric.add();
+    }
+    appliedValue = success ? value : UNKNOWN;
+    return success;
+}
+
+bool VolumeController::Impl::writeMasterVolume(float volumeLevel) {
+    return writeIfChanged(
+        masterState.volume, quantizeVolume(volumeLevel),
+        [&] { return backend->setMasterVolume(volumeLevel); });
+}
+
+bool VolumeController::Impl::writeMasterMute(int mute) {
+    return writeIfChanged(masterState.mute, mute != 0,
+                          [&] { return backend->setMasterMute(mute != 0); });
+}
+
+bool VolumeController::Impl::writeSessionVolume(Session &session,
+                                                float volumeLevel) {
+    return writeIfChanged(
+        session.applied.volume, quantizeVolume(volumeLevel),
+        [&] { return backend->setSessionVolume(session.id, volumeLevel); });
+}
+
+bool VolumeController::Impl::writeSessionMute(Session &session, int mute) {
+    return writeIfChanged(session.applied.mute, mute != 0, [&] {
+        return backend->setSessionMute(session.id, mute != 0);
+    });
+}
+
+bool VolumeController::Impl::setMasterVolume(float volumeLevel) {
+    // Thread-safe access to volume control
+    std::lock_guard<std::mutex> lock(mtx);
+    processSessionEvents();
+
+    // Clip volume level to valid range [0.0, 1.0]
+    return writeMasterVolume(std::clamp(volumeLevel, 0.0f, 1.0f));
+}
+
+bool VolumeController::Impl::setVolumeInternal(const std::string &processName,
+                                               float volumeLevel) {
+    // Clip volume level to valid range [0.0, 1.0]
+    volumeLevel = std::clamp(volumeLevel, 0.0f, 1.0f);
+
+    // Convert process name to lowercase for case-insensitive comparison
+    std::string processNameLower = sessionIndex.toLower(processName);
+
+    // Set volume for all sessions of the specified process
+    processSessionEvents();
+
+    // Special case for master volume
+    if (processNameLower == "master") {
+        return writeMasterVolume(volumeLevel);
+    }
+
+    for (const auto &session : sessionIndex.find(processNameLower)) {
+        if (!writeSessionVolume(*session.handle, volumeLevel)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VolumeController::Impl::setVolume(const std::string &processName,
+                                       float volumeLevel) {
+    // Thread-safe access to volume control
+    std::lock_guard<std::mutex> lock(mtx);
+    return setVolumeInternal(processName, volumeLevel);
+}
+
+bool VolumeController::Impl::setVolume(
+    const std::vector<std::string> &processNames, float volumeLevel) {
+    // Thread-safe access to volume control
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // Clip volume level to valid range [0.0, 1.0]
+    volumeLevel = std::clamp(volumeLevel, 0.0f, 1.0f);
+
+    // Set volume for all specified processes
+    for (const auto &processName : processNames) {
+        if (!setVolumeInternal(processName, volumeLevel)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VolumeController::Impl::setMasterMute(int mute) {
+    // Thread-safe access to mute control
+    std::lock_guard<std::mutex> lock(mtx);
+    processSessionEvents();
+
+    // Set master mute state
+    return writeMasterMute(mute);
+}
+
+bool VolumeController::Impl::setMuteInternal(const std::string &processName,
+                                             int mute) {
+    // Convert process name to lowercase for case-insensitive comparison
+    std::string processNameLower = sessionIndex.toLower(processName);
+
+    // Set mute for all sessions of the specified process
+    processSessionEvents();
+
+    // Special case for master mute
+    if (processNameLower == "master") {
+        return writeMasterMute(mute);
+    }
+
+    for (const auto &session : sessionIndex.find(processNameLower)) {
+        if (!writeSessionMute(*session.handle, mute)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VolumeController::Impl::setMute(const std::string &processName, int mute) {
+    // Thread-safe access to mute control
+    std::lock_guard<std::mutex> lock(mtx);
+    return setMuteInternal(processName, mute);
+}
+
+bool VolumeController::Impl::setMute(
+    const std::vector<std::string> &processNames, int mute) {
+    // Thread-safe access to mute control
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // Set mute for all specified processes
+    for (const auto &processName : processNames) {
+        if (!setMuteInternal(processName, mute)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool VolumeController::Impl::applyFrame(
+    std::span<const ChannelUpdate> updates) {
+    // One lock and one pass over the session notifications per frame
+    std::lock_guard<std::mutex> lock(mtx);
+    processSessionEvents();
+
+    bool success = true;
+    for (const ChannelUpdate &update : updates) {
+        float volumeLevel = std::clamp(update.volumeLevel, 0.0f, 1.0f);
+        bool setMute = update.mute != NO_MUTE;
+
+        if (update.master) {
+            if (update.setVolume) {
+                success &= writeMasterVolume(volumeLevel);
+            }
+            if (setMute) {
+                success &= writeMasterMute(update.mute);
+            }
+        }
+
+        // Each target's sessions serve both volume and mute
+        for (TargetId target : update.targets) {
+            if (target >= targetSessions.size()) {
+                continue;
+            }
+            TargetState &state = targetStates[target];
+            if (update.setVolume) {
+                state.known = true;
+                state.volumeLevel = volumeLevel;
+            }
+            if (setMute) {
+                state.mute = update.mute;
+            }
+            for (Session *session : targetSessions[target]) {
+                if (update.setVolume) {
+                    success &= writeSessionVolume(*session, volumeLevel);
+                }
+                if (setMute) {
+                    success &= writeSessionMute(*session, update.mute);
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+void VolumeController::Impl::setExternalChangeCallbacks(
+    ExternalChangeCallback callback, std::function<void()> notify) {
+    std::scoped_lock lock(mtx, eventMtx);
+    externalChangeCallback = std::move(callback);
+    notifyExternalChange = std::move(notify);
+}
+
+VolumeController::Stats VolumeController::Impl::getStats() const {
+    return {backendWrites.load(std::memory_order_relaxed),
+            writesSkipped.load(std::memory_order_relaxed),
+            externalChanges.load(std::memory_order_relaxed)};
+}
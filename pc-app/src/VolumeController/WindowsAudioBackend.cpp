@@ -0,0 +1,486 @@
+#include "WindowsAudioBackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+struct AudioSessionSinkTarget {
+    std::mutex mtx;
+    WindowsAudioBackend *backend;
+};
+
+namespace {
+
+// Passed with our own volume changes so their notifications can be ignored
+// {6C1F3A52-8E0D-4B7A-9D41-2F5E73A810C6}
+const GUID VOLWARE_EVENT_CONTEXT = {
+    0x6c1f3a52,
+    0x8e0d,
+    0x4b7a,
+    {0x9d, 0x41, 0x2f, 0x5e, 0x73, 0xa8, 0x10, 0xc6}};
+
+bool isOwnChange(LPCGUID eventContext) {
+    return eventContext && IsEqualGUID(*eventContext, VOLWARE_EVENT_CONTEXT);
+}
+
+/**
+ * Forwards sessions reported by IAudioSessionManager2 as they are created
+ */
+class SessionNotifier : public IAudioSessionNotification {
+public:
+    explicit SessionNotifier(std::shared_ptr<AudioSessionSinkTarget> target)
+        : m_target(std::move(target)) {}
+
+    // IUnknown
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG refCount = --m_refCount;
+        if (refCount == 0) {
+            delete this;
+        }
+        return refCount;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid,
+                                             void **ppvObject) override {
+        if (riid == __uuidof(IUnknown) ||
+            riid == __uuidof(IAudioSessionNotification)) {
+            *ppvObject = static_cast<IAudioSessionNotification *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    // IAudioSessionNotification
+    HRESULT STDMETHODCALLTYPE
+    OnSessionCreated(IAudioSessionControl *newSession) override {
+        std::lock_guard<std::mutex> lock(m_target->mtx);
+        if (newSession && m_target->backend) {
+            m_target->backend->handleSessionCreated(newSession);
+        }
+        return S_OK;
+    }
+
+private:
+    std::atomic<ULONG> m_refCount{1};
+    std::shared_ptr<AudioSessionSinkTarget> m_target;
+};
+
+/**
+ * Reports volume changes of the master endpoint made by other programs
+ */
+class EndpointVolumeEvents : public IAudioEndpointVolumeCallback {
+public:
+    explicit EndpointVolumeEvents(
+        std::shared_ptr<AudioSessionSinkTarget> target)
+        : m_target(std::move(target)) {}
+
+    // IUnknown
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG refCount = --m_refCount;
+        if (refCount == 0) {
+            delete this;
+        }
+        return refCount;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid,
+                                             void **ppvObject) override {
+        if (riid == __uuidof(IUnknown) ||
+            riid == __uuidof(IAudioEndpointVolumeCallback)) {
+            *ppvObject = static_cast<IAudioEndpointVolumeCallback *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    // IAudioEndpointVolumeCallback
+    HRESULT STDMETHODCALLTYPE
+    OnNotify(PAUDIO_VOLUME_NOTIFICATION_DATA data) override {
+        if (!data || isOwnChange(&data->guidEventContext)) {
+            return S_OK;
+        }
+        std::lock_guard<std::mutex> lock(m_target->mtx);
+        if (m_target->backend) {
+            m_target->backend->handleMasterVolumeChanged(
+                data->fMasterVolume, data->bMuted != FALSE);
+        }
+        return S_OK;
+    }
+
+private:
+    std::atomic<ULONG> m_refCount{1};
+    std::shared_ptr<AudioSessionSinkTarget> m_target;
+};
+
+/**
+ * Reports a single session once it expires or disconnects, and volume
+ * changes made to it by other programs
+ */
+class SessionEvents : public IAudioSessionEvents {
+public:
+    SessionEvents(AudioBackend::SessionId sessionId,
+                  std::shared_ptr<AudioSessionSinkTarget> target)
+        : m_sessionId(sessionId), m_target(std::move(target)) {}
+
+    // IUnknown
+    ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG refCount = --m_refCount;
+        if (refCount == 0) {
+            delete this;
+        }
+        return refCount;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid,
+                                             void **ppvObject) override {
+        if (riid == __uuidof(IUnknown) ||
+            riid == __uuidof(IAudioSessionEvents)) {
+            *ppvObject = static_cast<IAudioSessionEvents *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    // IAudioSessionEvents
+    HRESULT STDMETHODCALLTYPE
+    OnStateChanged(AudioSessionState newState) override {
+        if (newState == AudioSessionStateExpired) {
+            reportExpired();
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE
+    OnSessionDisconnected(AudioSessionDisconnectReason) override {
+        reportExpired();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDisplayNameChanged(LPCWSTR,
+                                                   LPCGUID) override {
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnIconPathChanged(LPCWSTR, LPCGUID) override {
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnSimpleVolumeChanged(
+        float newVolume, BOOL newMute, LPCGUID eventContext) override {
+        if (isOwnChange(eventContext)) {
+            return S_OK;
+        }
+        std::lock_guard<std::mutex> lock(m_target->mtx);
+        if (m_target->backend) {
+            m_target->backend->handleVolumeChanged(m_sessionId, newVolume,
+                                                   newMute != FALSE);
+        }
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnChannelVolumeChanged(DWORD, float[], DWORD,
+                                                     LPCGUID) override {
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE OnGroupingParamChanged(LPCGUID,
+                                                     LPCGUID) override {
+        return S_OK;
+    }
+
+private:
+    void reportExpired() {
+        std::lock_guard<std::mutex> lock(m_target->mtx);
+        if (m_target->backend) {
+            m_target->backend->handleSessionExpired(m_sessionId);
+        }
+    }
+
+    std::atomic<ULONG> m_refCount{1};
+    AudioBackend::SessionId m_sessionId;
+    std::shared_ptr<AudioSessionSinkTarget> m_target;
+};
+
+} // namespace
+
+WindowsAudioBackend::WindowsAudioBackend() {
+    if (!initializeCOM()) {
+        throw std::runtime_error("Failed to initialize COM.");
+    }
+}
+
+WindowsAudioBackend::~WindowsAudioBackend() {
+    // Detach the event sinks so late callbacks become no-ops
+    if (sinkTarget) {
+        std::lock_guard<std::mutex> lock(sinkTarget->mtx);
+        sinkTarget->backend = nullptr;
+    }
+
+    releaseSessions();
+    pSessionManager.Release();
+    pEndpointVolume.Release();
+    pDevice.Release();
+    pEnumerator.Release();
+    CoUninitialize();
+}
+
+bool WindowsAudioBackend::initializeCOM() {
+    // Initialize COM library
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hr)) {
+        return false;
+    }
+
+    // Create device enumerator
+    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                          __uuidof(IMMDeviceEnumerator),
+                          reinterpret_cast<void **>(&pEnumerator));
+
+    if (FAILED(hr)) {
+        CoUninitialize();
+        return false;
+    }
+
+    // Get default audio endpoint
+    hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDevice);
+    if (FAILED(hr)) {
+        CoUninitialize();
+        return false;
+    }
+
+    // Activate audio endpoint volume interface
+    hr = pDevice->Activate(__uuidof(IAudioEndpointVolume), CLSCTX_ALL, nullptr,
+                           reinterpret_cast<void **>(&pEndpointVolume));
+
+    if (FAILED(hr)) {
+        CoUninitialize();
+        return false;
+    }
+
+    // Activate audio session manager interface
+    hr = pDevice->Activate(__uuidof(IAudioSessionManager2), CLSCTX_ALL, nullptr,
+                           reinterpret_cast<void **>(&pSessionManager));
+
+    if (FAILED(hr)) {
+        CoUninitialize();
+        return false;
+    }
+
+    return true;
+}
+
+bool WindowsAudioBackend::start(Listener &sessionListener) {
+    std::lock_guard<std::mutex> lock(mtx);
+    listener = &sessionListener;
+
+    // Register for new sessions before enumerating so none are missed;
+    // sessions reported twice are filtered by their instance identifier
+    sinkTarget = std::make_shared<AudioSessionSinkTarget>();
+    sinkTarget->backend = this;
+    sessionNotifier.Attach(new SessionNotifier(sinkTarget));
+    HRESULT hr = pSessionManager->RegisterSessionNotification(sessionNotifier);
+    if (FAILED(hr)) {
+        sessionNotifier.Release();
+        return false;
+    }
+
+    // Watch the master endpoint for changes made by other programs
+    endpointEvents.Attach(new EndpointVolumeEvents(sinkTarget));
+    hr = pEndpointVolume->RegisterControlChangeNotify(endpointEvents);
+    if (FAILED(hr)) {
+        endpointEvents.Release();
+        return false;
+    }
+
+    // Report the sessions that already exist
+    CComPtr<IAudioSessionEnumerator> pSessionEnumerator = nullptr;
+    hr = pSessionManager->GetSessionEnumerator(&pSessionEnumerator);
+    if (FAILED(hr)) {
+        return false;
+    }
+
+    int sessionCount = 0;
+    hr = pSessionEnumerator->GetCount(&sessionCount);
+    if (FAILED(hr)) {
+        return false;
+    }
+
+    for (int i = 0; i < sessionCount; i++) {
+        CComPtr<IAudioSessionControl> pSessionControl = nullptr;
+        hr = pSessionEnumerator->GetSession(i, &pSessionControl);
+        if (SUCCEEDED(hr)) {
+            addSession(pSessionControl);
+        }
+    }
+
+    return true;
+}
+
+void WindowsAudioBackend::handleSessionCreated(
+    IAudioSessionControl *sessionControl) {
+    std::lock_guard<std::mutex> lock(mtx);
+    addSession(sessionControl);
+}
+
+void WindowsAudioBackend::handleSessionExpired(SessionId sessionId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = sessions.find(sessionId);
+    if (it == sessions.end()) {
+        return;
+    }
+
+    // Still inside the session's own callback, so only retire it here
+    sessionInstanceIds.erase(it->second.instanceId);
+    retiredSessions.push_back(std::move(it->second));
+    sessions.erase(it);
+    listener->onSessionRemoved(sessionId);
+}
+
+// The event sinks have already dropped notifications that carry
+// VOLWARE_EVENT_CONTEXT, so only changes of other programs get here
+void WindowsAudioBackend::handleVolumeChanged(SessionId sessionId,
+                                              float volumeLevel, bool mute) {
+    listener->onSessionVolumeChanged(sessionId, volumeLevel, mute);
+}
+
+void WindowsAudioBackend::handleMasterVolumeChanged(float volumeLevel,
+                                                    bool mute) {
+    listener->onMasterVolumeChanged(volumeLevel, mute);
+}
+
+void WindowsAudioBackend::addSession(IAudioSessionControl *sessionControl) {
+    // Expired sessions will never play again
+    AudioSessionState state = AudioSessionStateExpired;
+    HRESULT hr = sessionControl->GetState(&state);
+    if (FAILED(hr) || state == AudioSessionStateExpired) {
+        return;
+    }
+
+    CComPtr<IAudioSessionControl2> pSessionControl2 = nullptr;
+    hr = sessionControl->QueryInterface(
+        __uuidof(IAudioSessionControl2),
+        reinterpret_cast<void **>(&pSessionControl2));
+    if (FAILED(hr)) {
+        return;
+    }
+
+    // Skip sessions that are already known
+    LPWSTR instanceIdRaw = nullptr;
+    hr = pSessionControl2->GetSessionInstanceIdentifier(&instanceIdRaw);
+    if (FAILED(hr)) {
+        return;
+    }
+    std::wstring instanceId(instanceIdRaw);
+    CoTaskMemFree(instanceIdRaw);
+    if (sessionInstanceIds.contains(instanceId)) {
+        return;
+    }
+
+    DWORD processId = 0;
+    hr = pSessionControl2->GetProcessId(&processId);
+    if (FAILED(hr)) {
+        return;
+    }
+
+    CComPtr<ISimpleAudioVolume> pSimpleVolume = nullptr;
+    hr = sessionControl->QueryInterface(
+        __uuidof(ISimpleAudioVolume),
+        reinterpret_cast<void **>(&pSimpleVolume));
+    if (FAILED(hr)) {
+        return;
+    }
+
+    // Watch the session so it is reported once it expires
+    SessionId sessionId = nextSessionId++;
+    CComPtr<IAudioSessionEvents> pEvents;
+    pEvents.Attach(new SessionEvents(sessionId, sinkTarget));
+    hr = sessionControl->RegisterAudioSessionNotification(pEvents);
+    if (FAILED(hr)) {
+        return;
+    }
+
+    sessions[sessionId] = {sessionControl, pSimpleVolume, pEvents,
+                           instanceId};
+    sessionInstanceIds[instanceId] = sessionId;
+    listener->onSessionAdded(
+        {sessionId, processId, processNames.resolve(processId)});
+}
+
+CComPtr<ISimpleAudioVolume>
+WindowsAudioBackend::findSession(SessionId sessionId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    releaseRetiredSessions();
+
+    auto it = sessions.find(sessionId);
+    if (it == sessions.end()) {
+        return nullptr;
+    }
+    return it->second.volume;
+}
+
+void WindowsAudioBackend::releaseRetiredSessions() {
+    for (auto &session : retiredSessions) {
+        session.control->UnregisterAudioSessionNotification(session.events);
+    }
+    retiredSessions.clear();
+}
+
+void WindowsAudioBackend::releaseSessions() {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (sessionNotifier) {
+        pSessionManager->UnregisterSessionNotification(sessionNotifier);
+        sessionNotifier.Release();
+    }
+    if (endpointEvents) {
+        pEndpointVolume->UnregisterControlChangeNotify(endpointEvents);
+        endpointEvents.Release();
+    }
+
+    releaseRetiredSessions();
+    for (auto &[sessionId, session] : sessions) {
+        session.control->UnregisterAudioSessionNotification(session.events);
+    }
+    sessions.clear();
+    sessionInstanceIds.clear();
+}
+
+bool WindowsAudioBackend::setMasterVolume(float volumeLevel) {
+    HRESULT hr =
+        pEndpointVolume->SetMasterVolumeLevelScalar(volumeLevel,
+                                                 &VOLWARE_EVENT_CONTEXT);
+    return SUCCEEDED(hr);
+}
+
+bool WindowsAudioBackend::setMasterMute(bool mute) {
+    HRESULT hr = pEndpointVolume->SetMute(mute, &VOLWARE_EVENT_CONTEXT);
+    return SUCCEEDED(hr);
+}
+
+bool WindowsAudioBackend::setSessionVolume(SessionId sessionId,
+                                           float volumeLevel) {
+    // Sessions that expired in the meantime are simply skipped
+    CComPtr<ISimpleAudioVolume> pSimpleVolume = findSession(sessionId);
+    if (!pSimpleVolume) {
+        return true;
+    }
+    HRESULT hr = pSimpleVolume->SetMasterVolume(volumeLevel,
+                                                &VOLWARE_EVENT_CONTEXT);
+    return SUCCEEDED(hr);
+}
+
+bool WindowsAudioBackend::setSessionMute(SessionId sessionId, bool mute) {
+    CComPtr<ISimpleAudioVolume> pSimpleVolume = findSession(sessionId);
+    if (!pSimpleVolume) {
+        return true;
+    }
+    HRESULT hr = pSimpleVolume->SetMute(mute, &VOLWARE_EVENT_CONTEXT);
+    return SUCCEEDED(hr);
+}
@@ -1,123 +1,443 @@
+#include "ChannelFilter.h"
+#include "ChannelSync.h"
 #include "Config.h"
+#include "ConfigWatcher.h"
+#include "DispatchTable.h"
+#include "LatencyTracer.h"
+#include "MetricsServer.h"
+#include "SerialIoContext.h"
 #include "SerialReader.h"
+#include "ShutdownSignal.h"
+#include "VolumeApplier.h"
 #include "VolumeController.h"
+#include "VolwareProtocol.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 #if defined(_WIN32) || defined(_WIN64)
-
 #include "WindowsAutostart.h"
 #include "WindowsTray.h"
-#include <atomic>
 #include <windows.h>
+#endif
 
-// Global running flag
-std::atomic<bool> g_running = true;
+namespace {
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
-                   LPSTR lpCmdLine, int nCmdShow) {
-    try {
-        // Load configuration
-        Config config;
+// Longest time stopping may take before the process exits anyway
+constexpr unsigned int SHUTDOWN_TIMEOUT_MS = 2000;
 
-        // Set auto-start based on config
-        AutoStart::SetAutoStart(config.isAutoStart());
-
-        // Initialize volume controller
-        VolumeController volumeController;
-        Sleep(100);
-
-        // Initialize serial communication
-        SerialReader serialReader(config.getComPort(), config.getBaudRate());
-
-        // Set appropriate callback based on mute button configuration
-        if (config.isMuteButtons()) {
-            // Handle both volume and mute data
-            serialReader.setCallback([&volumeController,
-                                      &config](const std::vector<int> &data) {
-                for (int i = 0; i < data.size() && i < config.getChannelCount();
-                     ++i) {
-                    // Calculate volume level (0-1023 → 0.0-1.0)
-                    float volumeLevel = static_cast<float>(data[i]) / 1024.0f;
-
-                    // Invert if configured
-                    if (config.isInvertSlider()) {
-                        volumeLevel = 1.0f - volumeLevel;
-                    }
-
-                    // Get mute state
-                    int mute = data[i + config.getChannelCount() + 1];
-
-                    // Apply to all applications mapped to this channel
-                    const std::vector<std::string> &apps =
-                        config.getChannelApps().at(i);
-                    volumeController.setVolume(apps, volumeLevel);
-                    volumeController.setMute(apps, mute);
+/**
+ * Ends the process if it is still shutting down after SHUTDOWN_TIMEOUT_MS,
+ * e.g. because a serial driver never completes a cancelled read. Disarmed
+ * by destroying it.
+ */
+class ShutdownDeadline {
+public:
+    ShutdownDeadline()
+        : m_thread([](std::stop_token stopToken) {
+              std::mutex mutex;
+              std::condition_variable_any condition;
+              std::unique_lock<std::mutex> lock(mutex);
+              condition.wait_for(
+                  lock, stopToken,
+                  std::chrono::milliseconds(SHUTDOWN_TIMEOUT_MS),
+                  [] { return false; });
+              if (!stopToken.stop_requested()) {
+                  std::cerr << "Shutdown timed out." << std::endl;
+                  std::_Exit(1);
+              }
+          }) {}
+
+private:
+    std::jthread m_thread;
+};
+
+/**
+ * Installs the external change callbacks of a controller and removes them
+ * again when destroyed. The backend calls notify on its own threads until
+ * the controller is destroyed, which is after everything declared later in
+ * run(); declared after what the callbacks refer to, this detaches them
+ * before that goes away, on every return path.
+ */
+class ExternalChangeHookup {
+public:
+    ExternalChangeHookup(VolumeController &volumeController,
+                         VolumeController::ExternalChangeCallback callback,
+                         std::function<void()> notify)
+        : m_volumeController(volumeController) {
+        m_volumeController.setExternalChangeCallbacks(std::move(callback),
+                                                      std::move(notify));
+    }
+
+    // Waits for a callback running on a backend thread to return
+    ~ExternalChangeHookup() {
+        m_volumeController.setExternalChangeCallbacks({}, {});
+    }
+
+    ExternalChangeHookup(const ExternalChangeHookup &) = delete;
+    ExternalChangeHookup &operator=(const ExternalChangeHookup &) = delete;
+
+private:
+    VolumeController &m_volumeController;
+};
+
+// Detach the channels whose targets another program changed and tell
+// their devices the new state. Runs on the applier thread.
+void syncExternalChanges(
+    std::span<const VolumeController::ExternalChange> changes,
+    const Config &config, ChannelSync &channelSync,
+    const std::vector<std::unique_ptr<SerialReader>> &serialReaders) {
+    const DispatchTable &dispatchTable = config.getDispatchTable();
+    for (const VolumeController::ExternalChange &change : changes) {
+        int value = config.getResponseCurve().position(change.volumeLevel);
+        for (int channel = 0; channel < dispatchTable.channelCount();
+             channel++) {
+            if (!dispatchTable.isMapped(channel)) {
+                continue;
+            }
+            const DispatchTable::Channel &mapping =
+                dispatchTable.channel(channel);
+            std::span<const DispatchTable::TargetId> targets =
+                dispatchTable.targets(mapping);
+            bool affected =
+                change.master ? mapping.master
+                              : std::find(targets.begin(), targets.end(),
+                                          change.target) != targets.end();
+            if (affected) {
+                channelSync.externalChange(channel, value, change.mute);
+            }
+        }
+    }
+
+    // One message per device with all of its changed channels
+    std::uint32_t changed = channelSync.takeHostChanges();
+    const std::vector<DeviceConfig> &devices = config.getDevices();
+    for (std::size_t i = 0; i < devices.size() && i < serialReaders.size();
+         i++) {
+        std::array<int, volware::protocol::MAX_CHANNELS> values{};
+        std::uint8_t mask = 0;
+        std::uint8_t muteBits = 0;
+        for (int local = 0; local < devices[i].channelCount &&
+                            local < volware::protocol::MAX_CHANNELS;
+             local++) {
+            int channel = devices[i].channelOffset + local;
+            if (channel >= ChannelSync::MAX_CHANNELS ||
+                !(changed & (1u << channel))) {
+                continue;
+            }
+            mask |= 1u << local;
+            muteBits |= (channelSync.hostMute(channel) ? 1u : 0u) << local;
+            values[local] = channelSync.hostValue(channel);
+        }
+        if (mask) {
+            serialReaders[i]->sendHostState(mask, muteBits, values);
+        }
+    }
+}
+
+// Run until shutdown is requested. applySettings applies the settings
+// handled by the platform, initially and after each reload.
+int run(ShutdownSignal &shutdown, std::shared_ptr<const Config> initialConfig,
+        const std::function<void(const Config &)> &applySettings) {
+    // Armed once shutting down, and destroyed after everything else
+    std::optional<ShutdownDeadline> shutdownDeadline;
+
+    // Edits to the configuration file are picked up while running
+    const Config &config = *initialConfig;
+    ConfigWatcher configWatcher(initialConfig);
+    applySettings(config);
+
+    // Trace knob-to-volume latency if configured
+    if (config.isLatencyTracing()) {
+        LatencyTracer::global().enable(config.getLatencyLogIntervalMs(),
+                                       config.getLatencyTraceFile());
+    }
+
+    // Serve metrics on localhost if configured; failing to is not fatal
+    std::unique_ptr<MetricsServer> metricsServer;
+    if (config.getMetricsPort() != 0) {
+        metricsServer = std::make_unique<MetricsServer>(
+            MetricsRegistry::global(), config.getMetricsPort());
+        metricsServer->start();
+    }
+
+    // Initialize volume controller
+    VolumeController volumeController;
+
+    // All devices share one I/O thread; the readers are created below
+    SerialIoContext serialIo;
+    std::vector<std::unique_ptr<SerialReader>> serialReaders;
+
+    // Volume changes made by other programs, collected on the applier
+    // thread while a frame is applied
+    std::vector<VolumeController::ExternalChange> externalChanges;
+
+    // Apply channel values on a dedicated thread so a slow backend
+    // never stalls the serial reader; only the newest value of each
+    // channel is applied. Channels another program has changed ignore
+    // their knob until it is turned.
+    VolumeApplier volumeApplier(
+        [&volumeController, &configWatcher, &serialReaders,
+         &externalChanges, appliedConfig = std::shared_ptr<const Config>(),
+         channelSync = ChannelSync()](
+            std::span<const VolumeApplier::Update> updates) mutable {
+            // Switch to a reloaded configuration between frames, so a
+            // frame never mixes old and new targets
+            std::shared_ptr<const Config> config = configWatcher.current();
+            const DispatchTable &dispatchTable = config->getDispatchTable();
+            if (config != appliedConfig) {
+                volumeController.setTargets(dispatchTable.matcher());
+                appliedConfig = config;
+                externalChanges.clear(); // Refer to the old targets
+            }
+
+            std::array<VolumeController::ChannelUpdate,
+                       VolumeApplier::MAX_CHANNELS>
+                frame;
+            std::size_t count = 0;
+            for (const VolumeApplier::Update &update : updates) {
+                // Channels may have been unmapped by a reload
+                if (!dispatchTable.isMapped(update.channel)) {
+                    continue;
                 }
-            });
-        } else {
-            // Handle volume data only
-            serialReader.setCallback([&volumeController,
-                                      &config](const std::vector<int> &data) {
-                for (int i = 0; i < data.size() && i < config.getChannelCount();
-                     ++i) {
-                    // Calculate volume level (0-1023 → 0.0-1.0)
-                    float volumeLevel = static_cast<float>(data[i]) / 1024.0f;
-
-                    // Invert if configured
-                    if (config.isInvertSlider()) {
-                        volumeLevel = 1.0f - volumeLevel;
-                    }
-
-                    // Apply to all applications mapped to this channel
-                    const std::vector<std::string> &apps =
-                        config.getChannelApps().at(i);
-                    volumeController.setVolume(apps, volumeLevel);
+
+                // Repeats of a knob position another program has
+                // overridden are dropped
+                ChannelSync::Decision decision = channelSync.deviceUpdate(
+                    update.channel, update.value, update.mute);
+                if (!decision.volume && !decision.mute) {
+                    continue;
                 }
-            });
-        }
+
+                // Volume level from the response curve, which also
+                // inverts the slider if configured
+                float volumeLevel =
+                    config->getResponseCurve()[update.value];
+
+                // Apply to all applications mapped to this channel
+                const DispatchTable::Channel &channel =
+                    dispatchTable.channel(update.channel);
+                frame[count++] = {
+                    dispatchTable.targets(channel), channel.master,
+                    volumeLevel,
+                    decision.mute ? update.mute : VolumeApplier::NO_MUTE,
+                    decision.volume};
+            }
+
+            // All channels under one lock and one session lookup; an
+            // empty frame just collects the changes of other programs
+            volumeController.applyFrame(std::span(frame.data(), count));
+            if (!externalChanges.empty()) {
+                syncExternalChanges(externalChanges, *config, channelSync,
+                                    serialReaders);
+                externalChanges.clear();
+            }
+        });
+    ExternalChangeHookup externalChangeHookup(
+        volumeController,
+        [&externalChanges](const VolumeController::ExternalChange &change) {
+            externalChanges.push_back(change);
+        },
+        [&volumeApplier] { volumeApplier.wake(); });
+
+    // Initialize serial communication
+    serialIo.start();
+
+    for (std::size_t deviceIndex = 0;
+         deviceIndex < config.getDevices().size(); deviceIndex++) {
+        const DeviceConfig &device = config.getDevices()[deviceIndex];
+        auto serialReader = std::make_unique<SerialReader>(
+            serialIo.context(), device.comPort, device.baudRate);
+
+        // Hand changed channels to the applier, with mute data if
+        // configured; the device's channels start at its offset. Each
+        // channel's values are filtered first, which runs on the
+        // reader's strand only. Mute states are only passed on when they
+        // change.
+        std::array<ChannelFilter, VolumeApplier::MAX_CHANNELS> filters;
+        std::array<int, VolumeApplier::MAX_CHANNELS> postedMutes;
+        postedMutes.fill(VolumeApplier::NO_MUTE);
+        serialReader->setCallback([&volumeApplier, &configWatcher,
+                                   deviceIndex, filters, postedMutes](
+                                      const SerialFrame &frame) mutable {
+            volumeApplier.frameReceived();
+
+            // The current configuration; only the pointer swap is locked
+            std::shared_ptr<const Config> config = configWatcher.current();
+            if (deviceIndex >= config->getDevices().size()) {
+                return;
+            }
+            const DeviceConfig &device = config->getDevices()[deviceIndex];
+            const DispatchTable &dispatchTable = config->getDispatchTable();
+
+            // The filters need sample times; prefer the device's own
+            std::uint64_t sampleUs =
+                frame.hasDeviceTime ? frame.deviceTimeMs * 1000ull
+                : frame.receivedUs  ? frame.receivedUs
+                                    : LatencyTracer::nowUs();
+
+            // Values are followed by the mute states, if the board has
+            // mute buttons; binary frames say where the values end
+            std::span<const int> data = frame.values;
+            std::size_t valueCount =
+                frame.valueCount != SerialFrame::UNKNOWN_VALUE_COUNT
+                    ? static_cast<std::size_t>(frame.valueCount)
+                    : device.asciiValueCount(data.size());
+            for (int i = 0; static_cast<std::size_t>(i) < valueCount &&
+                            i < device.channelCount;
+                 ++i) {
+                // Only touch mapped channels that changed in this frame
+                int channel = device.channelOffset + i;
+                if (!(frame.changedChannels & (1u << i)) ||
+                    !dispatchTable.isMapped(channel)) {
+                    continue;
+                }
+
+                // Get mute state; boards may have fewer buttons than knobs
+                int mute = VolumeApplier::NO_MUTE;
+                bool hasButton =
+                    device.muteButtonCount == DeviceConfig::MUTE_PER_CHANNEL ||
+                    i < device.muteButtonCount;
+                if (hasButton && valueCount + i < data.size()) {
+                    mute = data[valueCount + i];
+                }
+
+                // Drop jitter, unless the mute state is what changed
+                std::optional<int> value = filters[i].process(
+                    data[i], sampleUs, config->getFilterSettings());
+                bool muteChanged = mute != VolumeApplier::NO_MUTE &&
+                                   mute != postedMutes[i];
+                if (!value && !muteChanged) {
+                    continue;
+                }
+                if (mute != VolumeApplier::NO_MUTE) {
+                    postedMutes[i] = mute;
+                }
+
+                volumeApplier.post(channel,
+                                   value.value_or(filters[i].output()),
+                                   mute, frame.receivedUs);
+            }
+        });
 
         // Set sync message for serial communication
-        serialReader.setSyncMessage("s");
+        serialReader->setSyncMessage("s");
+        if (config.isBinaryProtocol()) {
+            serialReader->setProtocol(SerialProtocol::Binary);
+        }
 
         // Start serial communication
-        if (!serialReader.start()) {
+        if (!serialReader->start()) {
             std::cerr << "Failed to start serial reader." << std::endl;
             return 1;
         }
+        serialReaders.push_back(std::move(serialReader));
+    }
 
-        // Create system tray icon
-        WindowsTray tray(hInstance, "VolWare Volume Controller");
+    // The applier reads serialReaders, so it starts once they are all
+    // in place; values received until then wait in its slots
+    volumeApplier.start();
 
-        // Set exit callback to cleanup gracefully
-        tray.setOnExitCallback([&]() {
-            g_running = false;
-            PostQuitMessage(0);
+    // After a reload, ask every device for its full state so remapped
+    // channels get their current value
+    configWatcher.setReloadCallback(
+        [&serialReaders,
+         &applySettings](const std::shared_ptr<const Config> &config) {
+            applySettings(*config);
+            for (auto &serialReader : serialReaders) {
+                serialReader->requestSync();
+            }
         });
+    configWatcher.start();
 
-        // Main message loop
-        MSG msg;
-        while (g_running) {
-            if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
-                if (msg.message == WM_QUIT) {
-                    g_running = false;
-                }
+    // Sleep until asked to exit; nothing here wakes up while idle
+    shutdown.wait();
+    std::cout << "Shutting down." << std::endl;
+    shutdownDeadline.emplace();
+
+    // Stop the components in the order data flows through them
+    configWatcher.stop();
+    for (auto &serialReader : serialReaders) {
+        serialReader->stop();
+    }
+    serialIo.stop();
+    volumeApplier.stop();
+    LatencyTracer::global().stop();
+    if (metricsServer) {
+        metricsServer->stop();
+    }
+
+    // Report the backend calls saved by skipping unchanged values
+    VolumeController::Stats stats = volumeController.getStats();
+    std::cout << "Backend writes: " << stats.backendWrites
+              << ", skipped as unchanged: " << stats.writesSkipped
+              << ", changed by other programs: " << stats.externalChanges
+              << std::endl;
+    return 0;
+}
+
+} // namespace
+
+#if defined(_WIN32) || defined(_WIN64)
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine, int nCmdShow) {
+    try {
+        ShutdownSignal shutdown;
+
+        // The tray icon's messages are dispatched while waiting for
+        // shutdown, and its Exit item requests it
+        WindowsTray tray(hInstance, "VolWare Volume Controller");
+        tray.setOnExitCallback([&shutdown] { shutdown.request(); });
+
+        // Set auto-start based on config
+        return run(shutdown, std::make_shared<const Config>(),
+                   [](const Config &config) {
+                       AutoStart::SetAutoStart(config.isAutoStart());
+                   });
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+#else
+
+// Headless daemon, stopped with SIGINT or SIGTERM, e.g. by systemd
+int main(int argc, char **argv) {
+    try {
+        // Blocks the termination signals, so before any thread is started
+        ShutdownSignal shutdown;
+
+        std::string configPath = "config.yaml";
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--config" && i + 1 < argc) {
+                configPath = argv[++i];
             } else {
-                // Sleep to reduce CPU usage in the main thread
-                Sleep(100);
+                std::cerr << "Usage: " << argv[0] << " [--config PATH]"
+                          << std::endl;
+                return arg == "--help" || arg == "-h" ? 0 : 1;
             }
         }
 
-        // Cleanup
-        serialReader.stop();
-        return 0;
+        return run(shutdown, std::make_shared<const Config>(configPath),
+                   [](const Config &) {});
     } catch (const std::exception &e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
 }
 
-#endif // _WIN32 || _WIN64
\ No newline at end of file
+#endif // _WIN32 || _WIN64
@@ -0,0 +1,213 @@
+/**
+ * AsciiFrameCheck - Firmware ASCII frame encoder on the host
+ *
+ * Compares encodeAsciiFrame() (VolwareProtocol.h) byte for byte with a
+ * formatter that builds the frame the way the sketch did before, by
+ * appending each value, mute state and comma to a String, dropping the
+ * last comma and adding a newline. Every channel count and mute count is
+ * checked with 0, VALUE_MAX, the values around each digit boundary and
+ * every mute pattern, followed by --frames random frames:
+ *
+ *   VolWareAsciiFrameCheck --frames 200000 --seed 1
+ *
+ * Values outside 0-VALUE_MAX, which the knob sampler never produces, must
+ * come out clamped. Stops at the first byte that differs and fails.
+ */
+
+#include "VolwareProtocol.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace protocol = volware::protocol;
+
+// Written after the frame buffer to catch the encoder overrunning it
+constexpr char GUARD = '#';
+constexpr std::size_t GUARD_SIZE = 16;
+
+// The sketch before encodeAsciiFrame(), with std::string for String:
+// "value1,value2,...,mute1,mute2,...\n"
+std::string referenceFrame(const std::vector<int> &values,
+                           std::uint8_t muteBits, std::size_t muteCount) {
+    std::string msg;
+    for (int value : values) {
+        msg += std::to_string(value);
+        msg += ",";
+    }
+    for (std::size_t i = 0; i < muteCount; i++) {
+        msg += std::to_string((muteBits >> i) & 1);
+        msg += ",";
+    }
+
+    // String::remove() ignores an index past the end, so an empty frame
+    // was a lone newline
+    if (!msg.empty()) {
+        msg.erase(msg.size() - 1);
+    }
+    msg += "\n";
+    return msg;
+}
+
+std::string describe(const std::vector<int> &values, std::uint8_t muteBits,
+                     std::size_t muteCount) {
+    std::string text = "values {";
+    for (std::size_t i = 0; i < values.size(); i++) {
+        text += (i ? ", " : "") + std::to_string(values[i]);
+    }
+    return text + "}, mute bits " + std::to_string(muteBits) + " of " +
+           std::to_string(muteCount);
+}
+
+std::string printable(char byte) {
+    return byte == '\n' ? "'\\n'"
+           : byte >= ' ' && byte <= '~'
+               ? std::string("'") + byte + "'"
+               : std::to_string(static_cast<unsigned char>(byte));
+}
+
+// Encode one frame and compare it with the reference, which is given the
+// values as the encoder should have clamped them. Prints the first
+// difference and returns false if there is one.
+bool checkFrame(const std::vector<int> &values, std::uint8_t muteBits,
+                std::size_t muteCount) {
+    std::vector<int> clamped(values.size());
+    std::transform(values.begin(), values.end(), clamped.begin(),
+                   [](int value) {
+                       return std::clamp(
+                           value, 0, static_cast<int>(protocol::VALUE_MAX));
+                   });
+    std::string expected = referenceFrame(clamped, muteBits, muteCount);
+
+    char buffer[protocol::MAX_ASCII_FRAME_SIZE + GUARD_SIZE];
+    std::memset(buffer, GUARD, sizeof(buffer));
+    std::size_t length = protocol::encodeAsciiFrame(
+        buffer, values.data(), static_cast<std::uint8_t>(values.size()),
+        muteBits, static_cast<std::uint8_t>(muteCount));
+
+    std::string problem;
+    if (length > protocol::MAX_ASCII_FRAME_SIZE ||
+        std::any_of(buffer + protocol::MAX_ASCII_FRAME_SIZE,
+                    buffer + sizeof(buffer),
+                    [](char byte) { return byte != GUARD; })) {
+        problem = "wrote past MAX_ASCII_FRAME_SIZE (" +
+                  std::to_string(protocol::MAX_ASCII_FRAME_SIZE) + " bytes)";
+    } else {
+        std::size_t common = std::min(length, expected.size());
+        std::size_t offset =
+            std::mismatch(buffer, buffer + common, expected.begin()).first -
+            buffer;
+        if (offset < common) {
+            problem = "byte " + std::to_string(offset) + " is " +
+                      printable(buffer[offset]) + ", expected " +
+                      printable(expected[offset]);
+        } else if (length != expected.size()) {
+            problem = std::to_string(length) + " bytes, expected " +
+                      std::to_string(expected.size());
+        }
+    }
+    if (!problem.empty()) {
+        std::cout << "FAILED  " << describe(values, muteBits, muteCount)
+                  << ": " << problem << "\n        expected "
+                  << expected.substr(0, expected.size() - 1) << "\\n"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Every channel and mute count with the same value on all channels and
+// every mute pattern
+bool checkEdgeCases(std::uint64_t &frames) {
+    const int max = protocol::VALUE_MAX;
+    const int edgeValues[] = {0,  1,   9,   10,      11,      99, 100,
+                              101, 999, 1000, max - 1, max,     -1, max + 1,
+                              -32768, 32767};
+    for (std::size_t channels = 0; channels <= protocol::MAX_CHANNELS;
+         channels++) {
+        for (std::size_t muteCount = 0; muteCount <= protocol::MAX_CHANNELS;
+             muteCount++) {
+            for (int value : edgeValues) {
+                std::vector<int> values(channels, value);
+                for (unsigned int muteBits = 0;
+                     muteBits < (1u << muteCount); muteBits++) {
+                    if (!checkFrame(values,
+                                    static_cast<std::uint8_t>(muteBits),
+                                    muteCount)) {
+                        return false;
+                    }
+                    frames++;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Frames with random counts, in-range values and mute bits
+bool checkRandomFrames(std::uint64_t count, std::uint64_t seed,
+                       std::uint64_t &frames) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<std::size_t> channelCount(
+        0, protocol::MAX_CHANNELS);
+    std::uniform_int_distribution<int> value(0, protocol::VALUE_MAX);
+    std::uniform_int_distribution<unsigned int> muteBits(0, 0xFF);
+    for (std::uint64_t i = 0; i < count; i++) {
+        std::vector<int> values(channelCount(rng));
+        for (int &channelValue : values) {
+            channelValue = value(rng);
+        }
+        if (!checkFrame(values, static_cast<std::uint8_t>(muteBits(rng)),
+                        channelCount(rng))) {
+            return false;
+        }
+        frames++;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        std::uint64_t frameCount = 200000;
+        std::uint64_t seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.starts_with("--") && i + 1 < argc) {
+                std::string value = argv[++i];
+                if (arg == "--frames") {
+                    frameCount = std::stoull(value);
+                } else if (arg == "--seed") {
+                    seed = std::stoull(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                std::cout << "Usage: VolWareAsciiFrameCheck [--frames N] "
+                             "[--seed N]\n";
+                return 1;
+            }
+        }
+
+        std::uint64_t frames = 0;
+        bool passed = checkEdgeCases(frames) &&
+                      checkRandomFrames(frameCount, seed, frames);
+        if (passed) {
+            std::cout << "All " << frames
+                      << " frames match the String-built format" << std::endl;
+        }
+        return passed ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,217 @@
+/**
+ * ButtonCheck - Firmware button debouncing on the host
+ *
+ * Runs the firmware's ButtonDebouncer (ButtonDebouncer.h) over contact
+ * traces sampled every millisecond, as the sketch polls its buttons, and
+ * checks the events it reports: contact chatter at press and release, a
+ * short press, a long press, and all of them again with millis() wrapping
+ * around during the press. Chatter is random, so --runs traces are tried
+ * with different bounce patterns:
+ *
+ *   VolWareButtonCheck --runs 1000 --seed 1
+ *
+ * Prints one line per scenario and fails if any event is missing, extra or
+ * late.
+ */
+
+#include "ButtonDebouncer.h"
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Same timing as the firmware
+constexpr volware::ButtonTiming TIMING = {
+    20,  // debounceMs
+    800, // longPressMs
+};
+
+// Bounce never lasts as long as the debounce time, or it would be presses
+constexpr std::uint32_t MAX_BOUNCE_MS = TIMING.debounceMs - 1;
+
+// A press starts this long into each trace and is released after holdMs
+constexpr std::uint32_t PRESS_AT_MS = 100;
+
+// The trace goes on this long after the release
+constexpr std::uint32_t TAIL_MS = 1000;
+
+struct Event {
+    volware::ButtonEvent type;
+    std::uint32_t atMs; // Since the start of the trace
+};
+
+struct Scenario {
+    const char *name;
+    std::uint32_t holdMs;
+    bool chatter;
+};
+
+const char *eventName(volware::ButtonEvent type) {
+    switch (type) {
+    case volware::BUTTON_PRESSED:
+        return "pressed";
+    case volware::BUTTON_RELEASED:
+        return "released";
+    case volware::BUTTON_LONG_PRESS:
+        return "long press";
+    default:
+        return "none";
+    }
+}
+
+// Contact state per millisecond: one press, and with chatter, random
+// bounce after its first edge and after the first edge of the release
+std::vector<bool> makeTrace(const Scenario &scenario, std::mt19937 &rng) {
+    std::uint32_t releaseMs = PRESS_AT_MS + scenario.holdMs;
+    std::vector<bool> trace(releaseMs + TAIL_MS, false);
+    for (std::uint32_t ms = PRESS_AT_MS; ms < releaseMs; ms++) {
+        trace[ms] = true;
+    }
+    if (scenario.chatter) {
+        std::uniform_int_distribution<std::uint32_t> bounceMs(1,
+                                                              MAX_BOUNCE_MS);
+        std::bernoulli_distribution contact(0.5);
+        for (std::uint32_t edgeMs : {PRESS_AT_MS, releaseMs}) {
+            std::uint32_t endMs = edgeMs + bounceMs(rng);
+            for (std::uint32_t ms = edgeMs + 1; ms < endMs; ms++) {
+                trace[ms] = contact(rng);
+            }
+        }
+    }
+    return trace;
+}
+
+// Events the debouncer must report: each edge at once, the long press
+// once the button has been held for longPressMs
+std::vector<Event> expectedEvents(const Scenario &scenario) {
+    std::vector<Event> events = {{volware::BUTTON_PRESSED, PRESS_AT_MS}};
+    if (scenario.holdMs >= TIMING.longPressMs) {
+        events.push_back(
+            {volware::BUTTON_LONG_PRESS, PRESS_AT_MS + TIMING.longPressMs});
+    }
+    events.push_back(
+        {volware::BUTTON_RELEASED, PRESS_AT_MS + scenario.holdMs});
+    return events;
+}
+
+// Feed the trace to a fresh debouncer, with millis() starting at startMs
+std::vector<Event> runTrace(const std::vector<bool> &trace,
+                            std::uint32_t startMs) {
+    volware::ButtonDebouncer debouncer;
+    std::vector<Event> events;
+    for (std::uint32_t ms = 0; ms < trace.size(); ms++) {
+        volware::ButtonEvent type =
+            debouncer.update(trace[ms], startMs + ms, TIMING);
+        if (type != volware::BUTTON_NONE) {
+            events.push_back({type, ms});
+        }
+    }
+    return events;
+}
+
+std::string describe(const std::vector<Event> &events) {
+    std::string text;
+    for (const Event &event : events) {
+        text += std::string(text.empty() ? "" : ", ") +
+                eventName(event.type) + " at " + std::to_string(event.atMs) +
+                " ms";
+    }
+    return text.empty() ? "no events" : text;
+}
+
+bool sameEvents(const std::vector<Event> &a, const std::vector<Event> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (a[i].type != b[i].type || a[i].atMs != b[i].atMs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        unsigned int runs = 1000;
+        unsigned int seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.starts_with("--") && i + 1 < argc) {
+                std::string value = argv[++i];
+                if (arg == "--runs") {
+                    runs = std::stoul(value);
+                } else if (arg == "--seed") {
+                    seed = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                std::cout << "Usage: VolWareButtonCheck [--runs N] "
+                             "[--seed N]\n";
+                return 1;
+            }
+        }
+        if (runs == 0) {
+            throw std::runtime_error("--runs must be positive");
+        }
+
+        const Scenario scenarios[] = {
+            {"contact chatter", 200, true},
+            {"short press", 50, false},
+            {"long press", 1500, false},
+            {"long press with chatter", 1500, true},
+        };
+
+        // millis() from boot, and wrapping around just after the press
+        // starts, so both the debounce and the long press span the wrap
+        const std::uint32_t wrapStartMs =
+            std::numeric_limits<std::uint32_t>::max() - PRESS_AT_MS - 10;
+        const std::pair<const char *, std::uint32_t> clocks[] = {
+            {"", 0},
+            {", millis() wrapping", wrapStartMs},
+        };
+
+        std::mt19937 rng(seed);
+        int failures = 0;
+        for (const auto &[clockName, startMs] : clocks) {
+            for (const Scenario &scenario : scenarios) {
+                std::vector<Event> expected = expectedEvents(scenario);
+                bool passed = true;
+                for (unsigned int run = 0;
+                     passed && run < (scenario.chatter ? runs : 1); run++) {
+                    std::vector<Event> events =
+                        runTrace(makeTrace(scenario, rng), startMs);
+                    if (!sameEvents(events, expected)) {
+                        std::cout << "  run " << run << ": "
+                                  << describe(events) << ", expected "
+                                  << describe(expected) << "\n";
+                        passed = false;
+                    }
+                }
+                std::cout << (passed ? "OK      " : "FAILED  ")
+                          << scenario.name << clockName << std::endl;
+                failures += !passed;
+            }
+        }
+
+        std::cout << (failures == 0
+                          ? "All checks passed"
+                          : "Failed checks: " + std::to_string(failures))
+                  << std::endl;
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
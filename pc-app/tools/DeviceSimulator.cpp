@@ -0,0 +1,595 @@
+/**
+ * DeviceSimulator - Emulates a VolWare device on a Linux pseudo-terminal
+ *
+ * Speaks the protocol of mcu/volware/volware.ino (ASCII lines, binary
+ * frames, the 's'/'b'/'a' requests, host state messages) so SerialReader
+ * can be exercised and benchmarked without hardware. Knob movement is
+ * either synthetic or replayed from a recording of a real device's ASCII
+ * output, e.g. `cat /dev/ttyACM0 > trace.txt`. Output is throttled to the
+ * configured baud rate, and faults can be injected to test the host's
+ * robustness.
+ *
+ * Point com_port in config.yaml at the --link path, which follows the
+ * current pty across simulated disconnects.
+ */
+
+#include "FrameParser.h"
+#include "VolwareProtocol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace protocol = volware::protocol;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> g_running = true;
+
+void handleSignal(int) { g_running = false; }
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct Options {
+    std::string linkPath = "/tmp/volware-tty";
+    std::string tracePath; // Replay this recording instead of a pattern
+    std::string pattern = "sine";
+    int channels = 5;
+    unsigned int baudRate = 115200;
+    double frameRate = 100.0; // Frames per second, 0 for as fast as possible
+    double duration = 0.0;    // Seconds, 0 to run until interrupted
+    unsigned int seed = 1;
+
+    // Fault injection
+    double partialProbability = 0.0; // Split a frame across two writes
+    double garbageProbability = 0.0; // Random bytes before a frame
+    double disconnectInterval = 0.0; // Seconds between hang-ups
+    double burstInterval = 0.0;      // Seconds between bursts
+    int burstFrames = 20;            // Frames per burst
+};
+
+void printUsage() {
+    std::cout
+        << "Usage: VolWareDeviceSim [options]\n"
+           "  --link PATH          Symlink to the current pty ("
+           "/tmp/volware-tty)\n"
+           "  --channels N         Potentiometer channels (5)\n"
+           "  --baud N             Baud rate used for throttling (115200)\n"
+           "  --rate HZ            Frames per second, 0 for the baud limit "
+           "(100)\n"
+           "  --pattern NAME       sine, ramp or random (sine)\n"
+           "  --trace FILE         Replay recorded ASCII frames instead\n"
+           "  --duration SEC       Stop after this long (run until Ctrl+C)\n"
+           "  --seed N             Random seed for patterns and faults (1)\n"
+           "  --partial P          Probability of splitting a frame\n"
+           "  --garbage P          Probability of garbage before a frame\n"
+           "  --disconnect SEC     Hang up and recreate the pty this often\n"
+           "  --burst SEC          Send a burst of frames this often\n"
+           "  --burst-frames N     Frames per burst (20)\n";
+}
+
+Options parseOptions(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--link") {
+            options.linkPath = value;
+        } else if (arg == "--channels") {
+            options.channels = std::stoi(value);
+        } else if (arg == "--baud") {
+            options.baudRate = std::stoul(value);
+        } else if (arg == "--rate") {
+            options.frameRate = std::stod(value);
+        } else if (arg == "--pattern") {
+            options.pattern = value;
+        } else if (arg == "--trace") {
+            options.tracePath = value;
+        } else if (arg == "--duration") {
+            options.duration = std::stod(value);
+        } else if (arg == "--seed") {
+            options.seed = std::stoul(value);
+        } else if (arg == "--partial") {
+            options.partialProbability = std::stod(value);
+        } else if (arg == "--garbage") {
+            options.garbageProbability = std::stod(value);
+        } else if (arg == "--disconnect") {
+            options.disconnectInterval = std::stod(value);
+        } else if (arg == "--burst") {
+            options.burstInterval = std::stod(value);
+        } else if (arg == "--burst-frames") {
+            options.burstFrames = std::stoi(value);
+        } else {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+    }
+
+    if (options.channels < 1 || options.channels > protocol::MAX_CHANNELS) {
+        throw std::runtime_error("--channels must be between 1 and 8.");
+    }
+    if (options.pattern != "sine" && options.pattern != "ramp" &&
+        options.pattern != "random") {
+        throw std::runtime_error("Unknown pattern " + options.pattern);
+    }
+    return options;
+}
+
+class DeviceSimulator {
+public:
+    explicit DeviceSimulator(const Options &options);
+    ~DeviceSimulator();
+
+    void run();
+    void printStats() const;
+
+private:
+    // Same noise threshold and keyframe interval as the firmware
+    static constexpr int NOISE_THRESHOLD = 2;
+    static constexpr double KEYFRAME_INTERVAL = 5.0;
+
+    // Pseudo-terminal handling
+    void openTerminal();
+    void closeTerminal();
+    bool waitForClient();
+    bool clientConnected() const;
+
+    // Device behaviour
+    void handleRequests();
+    void advanceKnobs();
+    void sendFrame(bool keyframe);
+    void sendBurst();
+
+    // Output with fault injection and baud rate throttling
+    void writeFrame(const std::string &frame);
+    void writeThrottled(const char *data, std::size_t size);
+
+    Options m_options;
+    std::mt19937 m_random;
+    int m_master = -1;
+
+    // Knob state
+    std::vector<int> m_values;
+    std::vector<int> m_sentValues;
+    std::vector<int> m_mutes;
+    std::vector<std::vector<int>> m_trace;
+    std::size_t m_tracePosition = 0;
+    std::uint64_t m_step = 0;
+
+    // Protocol state
+    bool m_binaryMode = false;
+    bool m_syncRequested = false;
+    protocol::HostStateDecoder m_hostState;
+    std::uint8_t m_sequence = 0;
+    Clock::time_point m_lastKeyframe;
+
+    // Throttling
+    Clock::time_point m_throttleStart;
+    std::uint64_t m_throttleBytes = 0;
+
+    // Statistics
+    Clock::time_point m_startTime;
+    std::uint64_t m_framesSent = 0;
+    std::uint64_t m_keyframesSent = 0;
+    std::uint64_t m_bytesSent = 0;
+    std::uint64_t m_syncRequests = 0;
+    std::uint64_t m_hostStates = 0;
+    std::uint64_t m_partialFrames = 0;
+    std::uint64_t m_garbageBytes = 0;
+    std::uint64_t m_bursts = 0;
+    std::uint64_t m_disconnects = 0;
+    std::vector<double> m_reconnectTimes; // Seconds from pty ready to open
+};
+
+DeviceSimulator::DeviceSimulator(const Options &options)
+    : m_options(options), m_random(options.seed),
+      m_values(options.channels, 0), m_sentValues(options.channels, -1),
+      m_mutes(options.channels, 0) {
+    if (!m_options.tracePath.empty()) {
+        // Recorded ASCII output of a device, one frame per line
+        std::ifstream file(m_options.tracePath);
+        if (!file) {
+            throw std::runtime_error("Failed to open trace file: " +
+                                     m_options.tracePath);
+        }
+
+        FrameParser parser;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::span<const int> values = parser.parse(line);
+            if (values.size() >= static_cast<std::size_t>(options.channels)) {
+                m_trace.emplace_back(values.begin(), values.end());
+            }
+        }
+        if (m_trace.empty()) {
+            throw std::runtime_error("Trace file holds no frames.");
+        }
+    }
+
+    openTerminal();
+}
+
+DeviceSimulator::~DeviceSimulator() {
+    closeTerminal();
+    unlink(m_options.linkPath.c_str());
+}
+
+void DeviceSimulator::openTerminal() {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_master < 0 || grantpt(m_master) != 0 || unlockpt(m_master) != 0) {
+        throw std::runtime_error("Failed to create pseudo-terminal.");
+    }
+
+    // Raw mode, like a USB serial adapter
+    termios settings;
+    tcgetattr(m_master, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(m_master, TCSANOW, &settings);
+
+    // Open and close the slave once, so the master reports a hang-up until
+    // the host opens it
+    const char *slaveName = ptsname(m_master);
+    int slave = open(slaveName, O_RDWR | O_NOCTTY);
+    if (slave >= 0) {
+        close(slave);
+    }
+
+    unlink(m_options.linkPath.c_str());
+    if (symlink(slaveName, m_options.linkPath.c_str()) != 0) {
+        throw std::runtime_error("Failed to create link " +
+                                 m_options.linkPath);
+    }
+    std::cout << "Device ready: " << m_options.linkPath << " -> "
+              << slaveName << std::endl;
+}
+
+void DeviceSimulator::closeTerminal() {
+    if (m_master >= 0) {
+        close(m_master);
+        m_master = -1;
+    }
+}
+
+bool DeviceSimulator::clientConnected() const {
+    // The master reports a hang-up while nobody has the slave open
+    pollfd pfd{m_master, POLLIN, 0};
+    poll(&pfd, 1, 0);
+    return !(pfd.revents & POLLHUP);
+}
+
+bool DeviceSimulator::waitForClient() {
+    Clock::time_point readyTime = Clock::now();
+    while (!clientConnected()) {
+        if (!g_running || (m_options.duration > 0 &&
+                           secondsSince(m_startTime) >= m_options.duration)) {
+            return false;
+        }
+
+        // Hang-ups cannot be waited for, so poll every millisecond
+        usleep(1000);
+    }
+
+    double reconnectTime = secondsSince(readyTime);
+    m_reconnectTimes.push_back(reconnectTime);
+    std::cout << "Client connected after " << reconnectTime * 1000.0
+              << " ms" << std::endl;
+
+    // A freshly plugged device starts in ASCII mode
+    m_binaryMode = false;
+    m_sentValues.assign(m_options.channels, -1);
+    m_throttleStart = Clock::now();
+    m_throttleBytes = 0;
+    return true;
+}
+
+void DeviceSimulator::handleRequests() {
+    char buffer[64];
+    ssize_t count;
+    while ((count = read(m_master, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t i = 0; i < count; i++) {
+            // Host state is only counted; the synthetic knobs carry on
+            if (m_hostState.feed(buffer[i])) {
+                if (m_hostState.ready()) {
+                    m_hostStates++;
+                }
+            } else if (buffer[i] == protocol::REQUEST_SYNC) {
+                m_syncRequested = true;
+                m_syncRequests++;
+            } else if (buffer[i] == protocol::REQUEST_BINARY) {
+                m_binaryMode = true;
+            } else if (buffer[i] == protocol::REQUEST_ASCII) {
+                m_binaryMode = false;
+            }
+        }
+    }
+}
+
+void DeviceSimulator::advanceKnobs() {
+    m_step++;
+
+    if (!m_trace.empty()) {
+        const std::vector<int> &frame = m_trace[m_tracePosition];
+        m_tracePosition = (m_tracePosition + 1) % m_trace.size();
+        for (int i = 0; i < m_options.channels; i++) {
+            m_values[i] = frame[i];
+            std::size_t muteIndex = m_options.channels + i;
+            m_mutes[i] = muteIndex < frame.size() ? frame[muteIndex] != 0 : 0;
+        }
+        return;
+    }
+
+    for (int i = 0; i < m_options.channels; i++) {
+        int value;
+        if (m_options.pattern == "sine") {
+            // One slow sweep every 2 s at 100 Hz, phase shifted per channel
+            double phase = m_step * 0.0314 + i * 1.2566;
+            value = static_cast<int>(511.5 + 511.5 * std::sin(phase));
+        } else if (m_options.pattern == "ramp") {
+            value = static_cast<int>((m_step * 4 + i * 200) % 2046);
+            value = value > 1023 ? 2046 - value : value;
+        } else {
+            std::uniform_int_distribution<int> delta(-8, 8);
+            value = std::clamp(m_values[i] + delta(m_random), 0, 1023);
+        }
+        m_values[i] = value;
+    }
+}
+
+void DeviceSimulator::sendFrame(bool keyframe) {
+    std::uint8_t changedMask = 0;
+    for (int i = 0; i < m_options.channels; i++) {
+        if (std::abs(m_values[i] - m_sentValues[i]) >= NOISE_THRESHOLD) {
+            changedMask |= 1u << i;
+        }
+    }
+    if (!keyframe && !changedMask) {
+        return;
+    }
+    for (int i = 0; i < m_options.channels; i++) {
+        if (keyframe || (changedMask & (1u << i))) {
+            m_sentValues[i] = m_values[i];
+        }
+    }
+
+    std::uint8_t muteBits = 0;
+    int values[protocol::MAX_CHANNELS] = {};
+    for (int i = 0; i < m_options.channels; i++) {
+        muteBits |= (m_mutes[i] ? 1u : 0u) << i;
+        values[i] = m_values[i];
+    }
+
+    std::string frame;
+    if (m_binaryMode) {
+
+        std::uint8_t buffer[protocol::MAX_FRAME_SIZE];
+        std::uint8_t mask =
+            keyframe ? (1u << m_options.channels) - 1 : changedMask;
+        std::uint8_t length = protocol::encodeFrame(
+            buffer, keyframe ? protocol::FRAME_FULL : protocol::FRAME_DELTA,
+            m_sequence++, mask, muteBits, values);
+        frame.assign(reinterpret_cast<const char *>(buffer), length);
+        if (keyframe) {
+            m_lastKeyframe = Clock::now();
+        }
+    } else {
+        // Same encoder as the firmware: values, then mute states
+        char buffer[protocol::MAX_ASCII_FRAME_SIZE];
+        std::uint8_t length = protocol::encodeAsciiFrame(
+            buffer, values, m_options.channels, muteBits, m_options.channels);
+        frame.assign(buffer, length);
+    }
+
+    writeFrame(frame);
+    m_framesSent++;
+    m_keyframesSent += keyframe ? 1 : 0;
+}
+
+void DeviceSimulator::sendBurst() {
+    // Frames back to back, as a device that was stalled would send them
+    for (int i = 0; i < m_options.burstFrames && g_running; i++) {
+        advanceKnobs();
+        sendFrame(false);
+    }
+    m_bursts++;
+}
+
+void DeviceSimulator::writeFrame(const std::string &frame) {
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    if (chance(m_random) < m_options.garbageProbability) {
+        std::uniform_int_distribution<int> length(1, 16);
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::string garbage(length(m_random), '\0');
+        for (char &c : garbage) {
+            c = static_cast<char>(byte(m_random));
+        }
+        writeThrottled(garbage.data(), garbage.size());
+        m_garbageBytes += garbage.size();
+    }
+
+    if (frame.size() > 1 && chance(m_random) < m_options.partialProbability) {
+        // Deliver the frame in two reads on the host side
+        std::size_t split = std::uniform_int_distribution<std::size_t>(
+            1, frame.size() - 1)(m_random);
+        writeThrottled(frame.data(), split);
+        usleep(2000);
+        writeThrottled(frame.data() + split, frame.size() - split);
+        m_partialFrames++;
+        return;
+    }
+
+    writeThrottled(frame.data(), frame.size());
+}
+
+void DeviceSimulator::writeThrottled(const char *data, std::size_t size) {
+    // 10 bits per byte on the wire: start, 8 data bits, stop
+    double bytesPerSecond = m_options.baudRate / 10.0;
+    m_throttleBytes += size;
+    auto due = m_throttleStart + std::chrono::duration_cast<Clock::duration>(
+                                     std::chrono::duration<double>(
+                                         m_throttleBytes / bytesPerSecond));
+    if (due > Clock::now()) {
+        std::this_thread::sleep_until(due);
+    }
+
+    while (size > 0) {
+        ssize_t written = write(m_master, data, size);
+        if (written < 0) {
+            if (errno != EAGAIN) {
+                return; // Client went away, noticed by the main loop
+            }
+            pollfd pfd{m_master, POLLOUT, 0};
+            poll(&pfd, 1, 10);
+            continue;
+        }
+        data += written;
+        size -= written;
+        m_bytesSent += written;
+    }
+}
+
+void DeviceSimulator::run() {
+    m_startTime = Clock::now();
+    Clock::time_point lastDisconnect = m_startTime;
+    Clock::time_point lastBurst = m_startTime;
+    Clock::duration frameInterval =
+        m_options.frameRate > 0
+            ? std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(1.0 / m_options.frameRate))
+            : Clock::duration::zero();
+    Clock::time_point nextFrame = Clock::now();
+
+    bool connected = false;
+    while (g_running) {
+        if (m_options.duration > 0 &&
+            secondsSince(m_startTime) >= m_options.duration) {
+            break;
+        }
+
+        if (!connected) {
+            if (!waitForClient()) {
+                break;
+            }
+            connected = true;
+            nextFrame = Clock::now();
+        } else if (!clientConnected()) {
+            std::cout << "Client disconnected" << std::endl;
+            connected = false;
+            continue;
+        }
+
+        // Simulated unplug: the host sees the port fail and must reopen it
+        if (m_options.disconnectInterval > 0 &&
+            secondsSince(lastDisconnect) >= m_options.disconnectInterval) {
+            std::cout << "Simulating disconnect" << std::endl;
+            closeTerminal();
+            openTerminal();
+            m_disconnects++;
+            lastDisconnect = Clock::now();
+            connected = false;
+            continue;
+        }
+
+        // Wait for the next frame while answering requests
+        pollfd pfd{m_master, POLLIN, 0};
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            nextFrame - Clock::now());
+        poll(&pfd, 1, std::max<int>(0, wait.count()));
+        handleRequests();
+        if (Clock::now() < nextFrame && !m_syncRequested) {
+            continue;
+        }
+
+        if (m_options.burstInterval > 0 &&
+            secondsSince(lastBurst) >= m_options.burstInterval) {
+            sendBurst();
+            lastBurst = Clock::now();
+        }
+
+        advanceKnobs();
+        bool keyframeDue =
+            m_binaryMode && secondsSince(m_lastKeyframe) >= KEYFRAME_INTERVAL;
+        sendFrame(m_syncRequested || keyframeDue);
+        m_syncRequested = false;
+        nextFrame += frameInterval;
+        if (nextFrame < Clock::now() - std::chrono::seconds(1)) {
+            nextFrame = Clock::now(); // Do not try to catch up after a stall
+        }
+    }
+}
+
+void DeviceSimulator::printStats() const {
+    double elapsed = secondsSince(m_startTime);
+    std::cout << "\nRan for " << elapsed << " s\n"
+              << "Frames sent:     " << m_framesSent << " ("
+              << m_keyframesSent << " keyframes, " << m_framesSent / elapsed
+              << " per second)\n"
+              << "Bytes sent:      " << m_bytesSent << " ("
+              << m_bytesSent / elapsed << " per second)\n"
+              << "Sync requests:   " << m_syncRequests << "\n"
+              << "Host states:     " << m_hostStates << "\n"
+              << "Faults injected: " << m_partialFrames << " partial frames, "
+              << m_garbageBytes << " garbage bytes, " << m_bursts
+              << " bursts, " << m_disconnects << " disconnects\n";
+
+    if (!m_reconnectTimes.empty()) {
+        auto [minTime, maxTime] = std::minmax_element(m_reconnectTimes.begin(),
+                                                      m_reconnectTimes.end());
+        double total = 0;
+        for (double time : m_reconnectTimes) {
+            total += time;
+        }
+        std::cout << "Connect time:    min " << *minTime * 1000.0 << " ms, avg "
+                  << total / m_reconnectTimes.size() * 1000.0 << " ms, max "
+                  << *maxTime * 1000.0 << " ms over "
+                  << m_reconnectTimes.size() << " connects\n";
+    }
+    std::cout << std::flush;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+
+        std::signal(SIGINT, handleSignal);
+        std::signal(SIGTERM, handleSignal);
+
+        DeviceSimulator simulator(options);
+        simulator.run();
+        simulator.printStats();
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
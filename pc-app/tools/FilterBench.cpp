@@ -0,0 +1,395 @@
+/**
+ * FilterBench - Compares knob filter settings on noisy input
+ *
+ * Runs a set of ChannelFilter configurations over the same knob values and
+ * reports how many volume writes each would cause. The values are either a
+ * recording of a real device's ASCII output (`cat /dev/ttyACM0 >
+ * trace.txt`, then --trace trace.txt, sampled at --rate) or a synthetic
+ * trace of knob moves and rests with ADC noise. Synthetic traces also know
+ * the true knob position, so the error at rest and the lag behind the
+ * knob at the end of each move are reported as well.
+ *
+ * Synthetic readings pass the firmware's own oversampling and noise
+ * threshold (KnobSampler.h) first, as they do on a real device, so
+ * --oversample shows what averaging on the device saves on the host.
+ * Recorded values have been through the firmware already.
+ */
+
+#include "ChannelFilter.h"
+#include "FrameParser.h"
+#include "KnobSampler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Same noise threshold as the firmware
+constexpr int NOISE_THRESHOLD = 2;
+
+// An output this close to the knob counts as settled (about 1%)
+constexpr int SETTLE_TOLERANCE = 10;
+
+struct Sample {
+    std::uint64_t timeUs;
+    int value;
+    int truth; // True knob position, -1 for recordings
+};
+
+// A knob move in a synthetic trace
+struct Move {
+    std::uint64_t startUs;
+    std::uint64_t nearUs; // The knob is within SETTLE_TOLERANCE of target
+    std::uint64_t endUs;
+    int target;
+};
+
+// Time after a move that still counts as moving for the rest error
+constexpr std::uint64_t REST_MARGIN_US = 500'000;
+
+struct Channel {
+    std::vector<Sample> samples; // As sent by the device
+    std::vector<Move> moves;
+    std::uint64_t durationUs = 0;
+};
+
+struct Options {
+    std::string tracePath;
+    int channels = 5;
+    double rate = 100.0;    // ADC samples per second
+    double duration = 60.0; // Seconds of synthetic trace
+    double noise = 1.5;     // ADC noise, standard deviation in raw steps
+    int oversample = 8;     // ADC readings averaged per value
+    unsigned int seed = 1;
+};
+
+struct Variant {
+    const char *name;
+    FilterSettings settings;
+};
+
+struct Result {
+    std::uint64_t writes = 0;
+    double restError = 0.0; // Mean absolute error while at rest
+    std::uint64_t restSamples = 0;
+    std::vector<double> settleMs;
+    int unsettled = 0;
+};
+
+void printUsage() {
+    std::cout
+        << "Usage: VolWareFilterBench [options]\n"
+           "  --trace FILE     Recorded ASCII frames instead of a synthetic "
+           "trace\n"
+           "  --channels N     Knobs in the trace (5)\n"
+           "  --rate HZ        Values per second and knob (100)\n"
+           "  --duration SEC   Length of the synthetic trace (60)\n"
+           "  --noise STEPS    Synthetic ADC noise, standard deviation "
+           "(1.5)\n"
+           "  --oversample N   Synthetic ADC readings averaged per value, "
+           "1-64 (8)\n"
+           "  --seed N         Random seed of the synthetic trace (1)\n";
+}
+
+Options parseOptions(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--trace") {
+            options.tracePath = value;
+        } else if (arg == "--channels") {
+            options.channels = std::stoi(value);
+        } else if (arg == "--rate") {
+            options.rate = std::stod(value);
+        } else if (arg == "--duration") {
+            options.duration = std::stod(value);
+        } else if (arg == "--noise") {
+            options.noise = std::stod(value);
+        } else if (arg == "--oversample") {
+            options.oversample = std::stoi(value);
+        } else if (arg == "--seed") {
+            options.seed = std::stoul(value);
+        } else {
+            throw std::runtime_error("Unknown option " + arg);
+        }
+    }
+    if (options.channels < 1 || options.rate <= 0.0) {
+        throw std::runtime_error("Invalid --channels or --rate");
+    }
+    if (options.oversample < 1 || options.oversample > 64 ||
+        !std::has_single_bit(static_cast<unsigned>(options.oversample))) {
+        throw std::runtime_error("--oversample must be a power of two");
+    }
+    return options;
+}
+
+// Keep only the values the firmware would send
+void addReading(Channel &channel, volware::KnobSampler &sampler,
+                std::uint64_t timeUs, int reading, int truth) {
+    if (sampler.addReading(reading) && sampler.takeChanged()) {
+        channel.samples.push_back({timeUs, sampler.values()[0], truth});
+    }
+    channel.durationUs = timeUs;
+}
+
+std::vector<Channel> loadTrace(const Options &options) {
+    std::ifstream file(options.tracePath);
+    if (!file) {
+        throw std::runtime_error("Failed to open trace file: " +
+                                 options.tracePath);
+    }
+
+    std::vector<Channel> channels(options.channels);
+    std::vector<volware::KnobSampler> samplers(
+        options.channels, volware::KnobSampler(1, 0, NOISE_THRESHOLD));
+    FrameParser parser;
+    std::string line;
+    std::uint64_t step = 0;
+    while (std::getline(file, line)) {
+        std::span<const int> values = parser.parse(line);
+        if (values.size() < static_cast<std::size_t>(options.channels)) {
+            continue;
+        }
+        std::uint64_t timeUs = static_cast<std::uint64_t>(step++ * 1e6 /
+                                                          options.rate);
+        for (int i = 0; i < options.channels; i++) {
+            addReading(channels[i], samplers[i], timeUs, values[i], -1);
+        }
+    }
+    if (step == 0) {
+        throw std::runtime_error("Trace file holds no frames.");
+    }
+    return channels;
+}
+
+// Rests of 0.5-4 s and moves of 100-800 ms, with noise and rare spikes
+std::vector<Channel> synthesize(const Options &options) {
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<double> restSeconds(0.5, 4.0);
+    std::uniform_real_distribution<double> moveSeconds(0.1, 0.8);
+    std::uniform_int_distribution<int> target(0, 1023);
+    std::normal_distribution<double> noise(0.0, options.noise);
+    std::bernoulli_distribution spike(0.002);
+
+    std::vector<Channel> channels(options.channels);
+    double stepSeconds = 1.0 / options.rate;
+    int oversampleShift = std::countr_zero(
+        static_cast<unsigned>(options.oversample));
+    for (Channel &channel : channels) {
+        volware::KnobSampler sampler(1, oversampleShift, NOISE_THRESHOLD);
+        double position = target(random);
+        double time = 0.0;
+        while (time < options.duration) {
+            // Rest, then move to a new target
+            double restEnd = time + restSeconds(random);
+            double moveStart = restEnd;
+            double moveEnd = moveStart + moveSeconds(random);
+            double from = position;
+            int to = target(random);
+            // When the eased movement gets within tolerance of its target
+            double distance = std::abs(to - from);
+            double nearFraction =
+                distance > SETTLE_TOLERANCE
+                    ? std::acos(2.0 * SETTLE_TOLERANCE / distance - 1.0) /
+                          std::numbers::pi
+                    : 0.0;
+            double moveNear = moveStart + (moveEnd - moveStart) * nearFraction;
+            channel.moves.push_back(
+                {static_cast<std::uint64_t>(moveStart * 1e6),
+                 static_cast<std::uint64_t>(moveNear * 1e6),
+                 static_cast<std::uint64_t>(moveEnd * 1e6), to});
+
+            for (; time < moveEnd && time < options.duration;
+                 time += stepSeconds) {
+                if (time >= moveStart) {
+                    // Smooth start and stop, like a hand
+                    double t = (time - moveStart) / (moveEnd - moveStart);
+                    position =
+                        from + (to - from) *
+                                   (0.5 - 0.5 * std::cos(t * std::numbers::pi));
+                }
+                for (int n = 0; n < options.oversample; n++) {
+                    double reading = position + noise(random);
+                    if (spike(random)) {
+                        reading += noise(random) * 10.0;
+                    }
+                    addReading(
+                        channel, sampler,
+                        static_cast<std::uint64_t>(time * 1e6),
+                        std::clamp(static_cast<int>(std::lround(reading)), 0,
+                                   1023),
+                        static_cast<int>(std::lround(position)));
+                }
+            }
+            position = to;
+        }
+    }
+    return channels;
+}
+
+Result run(const std::vector<Channel> &channels,
+           const FilterSettings &settings) {
+    Result result;
+    for (const Channel &channel : channels) {
+        ChannelFilter filter;
+        std::vector<std::pair<std::uint64_t, int>> outputs;
+        for (const Sample &sample : channel.samples) {
+            std::optional<int> output =
+                filter.process(sample.value, sample.timeUs, settings);
+            if (output) {
+                outputs.emplace_back(sample.timeUs, *output);
+                result.writes++;
+            }
+            if (sample.truth >= 0) {
+                // Measure jitter only where the knob is still
+                bool moving = std::any_of(
+                    channel.moves.begin(), channel.moves.end(),
+                    [&](const Move &move) {
+                        return sample.timeUs >= move.startUs &&
+                               sample.timeUs < move.endUs + REST_MARGIN_US;
+                    });
+                if (!moving) {
+                    result.restError +=
+                        std::abs(filter.output() - sample.truth);
+                    result.restSamples++;
+                }
+            }
+        }
+
+        // Delay from the knob getting near the target of each move to the
+        // output getting there, before the next move starts
+        for (std::size_t m = 0; m < channel.moves.size(); m++) {
+            const Move &move = channel.moves[m];
+            if (move.endUs > channel.durationUs) {
+                break;
+            }
+            std::uint64_t limitUs = m + 1 < channel.moves.size()
+                                        ? channel.moves[m + 1].startUs
+                                        : channel.durationUs;
+            auto settled = std::find_if(
+                outputs.begin(), outputs.end(), [&](const auto &output) {
+                    return output.first >= move.startUs &&
+                           std::abs(output.second - move.target) <=
+                               SETTLE_TOLERANCE;
+                });
+            if (settled != outputs.end() && settled->first <= limitUs) {
+                result.settleMs.push_back(
+                    settled->first > move.nearUs
+                        ? (settled->first - move.nearUs) / 1000.0
+                        : 0.0);
+            } else {
+                result.unsettled++;
+            }
+        }
+    }
+    return result;
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[static_cast<std::size_t>(fraction * (values.size() - 1))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        bool synthetic = options.tracePath.empty();
+        std::vector<Channel> channels =
+            synthetic ? synthesize(options) : loadTrace(options);
+
+        FilterSettings raw;
+        FilterSettings hysteresis;
+        hysteresis.hysteresis = 4;
+        FilterSettings ema;
+        ema.mode = FilterMode::Ema;
+        ema.hysteresis = 2;
+        FilterSettings oneEuro;
+        oneEuro.mode = FilterMode::OneEuro;
+        oneEuro.hysteresis = 2;
+        FilterSettings oneEuroDeadzone = oneEuro;
+        oneEuroDeadzone.hysteresis = 4;
+        oneEuroDeadzone.deadzone = 8;
+
+        const Variant variants[] = {
+            {"raw", raw},
+            {"hysteresis 4", hysteresis},
+            {"ema 20ms, hyst 2", ema},
+            {"one_euro, hyst 2", oneEuro},
+            {"one_euro, hyst 4, dz 8", oneEuroDeadzone},
+        };
+
+        std::uint64_t samples = 0;
+        for (const Channel &channel : channels) {
+            samples += channel.samples.size();
+        }
+        std::cout << (synthetic ? "Synthetic" : "Recorded") << " trace: "
+                  << channels.size() << " channels, " << samples
+                  << " values sent\n\n";
+        std::cout << std::left << std::setw(24) << "filter" << std::right
+                  << std::setw(9) << "writes" << std::setw(8) << "saved";
+        if (synthetic) {
+            std::cout << std::setw(12) << "rest err" << std::setw(11)
+                      << "lag p50" << std::setw(11) << "lag p99"
+                      << std::setw(11) << "unsettled";
+        }
+        std::cout << '\n';
+
+        std::uint64_t baseline = 0;
+        for (const Variant &variant : variants) {
+            Result result = run(channels, variant.settings);
+            if (baseline == 0) {
+                baseline = result.writes;
+            }
+            std::cout << std::left << std::setw(24) << variant.name
+                      << std::right << std::setw(9) << result.writes
+                      << std::setw(7) << std::fixed << std::setprecision(0)
+                      << (baseline ? 100.0 * (1.0 - static_cast<double>(
+                                                        result.writes) /
+                                                        baseline)
+                                   : 0.0)
+                      << '%';
+            if (synthetic) {
+                std::cout << std::setprecision(2) << std::setw(12)
+                          << (result.restSamples
+                                  ? result.restError / result.restSamples
+                                  : 0.0)
+                          << std::setprecision(1) << std::setw(9)
+                          << percentile(result.settleMs, 0.5) << "ms"
+                          << std::setw(9)
+                          << percentile(result.settleMs, 0.99) << "ms"
+                          << std::setw(11) << result.unsettled;
+            }
+            std::cout << '\n';
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
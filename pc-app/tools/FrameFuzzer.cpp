@@ -0,0 +1,126 @@
+/**
+ * FrameFuzzer - libFuzzer entry point for the serial frame decoder
+ *
+ * Feeds arbitrary bytes to FrameDecoder, and through it to FrameParser, the
+ * way SerialReader does: in reads of varying size, appended to a buffer
+ * that is decoded until the decoder needs more input. Besides crashes and
+ * sanitizer reports, it aborts when a result breaks the decoder's
+ * contract, e.g. consuming more than it was given or returning more values
+ * than FrameParser::MAX_VALUES.
+ *
+ * With Clang the tool is linked against libFuzzer and run as
+ * `VolWareFrameFuzzer corpus/`. Other compilers build a replay driver that
+ * runs each file given on the command line once, e.g. to check a crash
+ * found elsewhere.
+ */
+
+#include "FrameDecoder.h"
+#include "FrameParser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#ifdef VOLWARE_FUZZ_REPLAY
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#endif
+
+namespace {
+
+void check(bool condition) {
+    if (!condition) {
+        std::abort();
+    }
+}
+
+void checkFrame(const SerialFrame &frame) {
+    check(frame.values.size() <= FrameParser::MAX_VALUES);
+    if (frame.valueCount != SerialFrame::UNKNOWN_VALUE_COUNT) {
+        // Binary frames: every channel value has a mute state
+        check(frame.valueCount >= 0 &&
+              static_cast<std::size_t>(frame.valueCount) * 2 ==
+                  frame.values.size());
+    }
+    if (!frame.keyframe) {
+        // Deltas are binary and only flag channels the keyframe has
+        check(frame.valueCount >= 0 && frame.valueCount < 32 &&
+              (frame.changedChannels >> frame.valueCount) == 0);
+    }
+}
+
+// Decode everything buffered, like SerialReader::readComplete
+void decodeBuffer(FrameDecoder &decoder, std::string &buffer) {
+    while (!buffer.empty()) {
+        FrameDecoder::Result result = decoder.decode(buffer);
+        check(result.consumed <= buffer.size());
+        if (result.frameReady) {
+            checkFrame(decoder.frame());
+        }
+        if (result.consumed == 0) {
+            break;
+        }
+        buffer.erase(0, result.consumed);
+    }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data,
+                                      std::size_t size) {
+    std::string_view input(reinterpret_cast<const char *>(data), size);
+
+    // The whole input as one line, as the ASCII path sees it
+    FrameParser parser;
+    check(parser.parse(input).size() <= FrameParser::MAX_VALUES);
+
+    // The first byte picks the read size, so frames are split across reads
+    // at different points
+    if (input.empty()) {
+        return 0;
+    }
+    std::size_t readSize = static_cast<std::uint8_t>(input.front()) % 64 + 1;
+    input.remove_prefix(1);
+
+    FrameDecoder decoder;
+    std::string buffer;
+    while (!input.empty()) {
+        std::size_t length = std::min(readSize, input.size());
+        buffer.append(input.substr(0, length));
+        input.remove_prefix(length);
+        decodeBuffer(decoder, buffer);
+    }
+
+    // Stream state must not survive a reconnect
+    decoder.reset();
+    check(!decoder.isBinary());
+    buffer.clear();
+    return 0;
+}
+
+#ifdef VOLWARE_FUZZ_REPLAY
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: VolWareFrameFuzzer FILE...\n";
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot read " << argv[i] << '\n';
+            return 1;
+        }
+        std::string input((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(
+            reinterpret_cast<const std::uint8_t *>(input.data()),
+            input.size());
+    }
+    std::cout << "Ran " << argc - 1 << " inputs\n";
+    return 0;
+}
+#endif
@@ -0,0 +1,303 @@
+/**
+ * ParseBench - Cost of parsing serial frames
+ *
+ * Measures nanoseconds and heap allocations per frame on the parse path:
+ * FrameParser alone on ASCII lines, and FrameDecoder on an ASCII stream and
+ * on a binary stream of keyframes and single-channel deltas, as the
+ * firmware sends them. The frames are generated with the firmware's own
+ * encoders and decoded straight from one buffer, so the numbers exclude
+ * serial I/O:
+ *
+ *   VolWareParseBench --frames 1000000 --channels 5
+ *
+ * For comparison, the same lines also go through the line parsing that
+ * SerialReader used before FrameParser: std::getline from a stream over the
+ * read buffer, then std::istringstream and std::stoi per field into a new
+ * vector.
+ *
+ * Allocations are counted through the global operator new of this tool.
+ * The parse path is meant to be allocation-free, so the benchmark fails if
+ * any frame allocates; the old line parsing is exempt.
+ */
+
+#include "FrameDecoder.h"
+#include "FrameParser.h"
+#include "VolwareProtocol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+
+using Clock = std::chrono::steady_clock;
+
+namespace protocol = volware::protocol;
+
+// Distinct frames per stream, decoded in a loop
+constexpr std::size_t STREAM_FRAMES = 4096;
+
+// Every this many frames the binary stream sends a keyframe
+constexpr std::size_t KEYFRAME_INTERVAL = 100;
+
+struct Result {
+    std::uint64_t frames = 0;
+    std::uint64_t allocations = 0;
+    double seconds = 0;
+    std::uint64_t checksum = 0; // Keeps the work from being optimised away
+};
+
+// Knob values that drift like a hand turning the knobs
+std::vector<std::vector<int>> makeValues(std::size_t channels,
+                                         std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> step(-8, 8);
+    std::vector<int> values(channels, protocol::VALUE_MAX / 2);
+    std::vector<std::vector<int>> frames;
+    for (std::size_t i = 0; i < STREAM_FRAMES; i++) {
+        int &value = values[i % channels];
+        value = std::clamp(value + step(rng), 0,
+                           static_cast<int>(protocol::VALUE_MAX));
+        frames.push_back(values);
+    }
+    return frames;
+}
+
+std::string makeAsciiStream(const std::vector<std::vector<int>> &frames) {
+    std::string stream;
+    char line[protocol::MAX_ASCII_FRAME_SIZE];
+    for (const std::vector<int> &values : frames) {
+        std::uint8_t channels = static_cast<std::uint8_t>(values.size());
+        stream.append(line, protocol::encodeAsciiFrame(line, values.data(),
+                                                       channels, 0b101,
+                                                       channels));
+    }
+    return stream;
+}
+
+std::string makeBinaryStream(const std::vector<std::vector<int>> &frames) {
+    std::string stream;
+    std::uint8_t frame[protocol::MAX_FRAME_SIZE];
+    std::uint8_t allChannels =
+        static_cast<std::uint8_t>((1u << frames.front().size()) - 1);
+    for (std::size_t i = 0; i < frames.size(); i++) {
+        bool keyframe = i % KEYFRAME_INTERVAL == 0;
+        std::uint8_t type =
+            (keyframe ? protocol::FRAME_FULL : protocol::FRAME_DELTA) |
+            protocol::FRAME_FLAG_TIME;
+        std::uint8_t mask =
+            keyframe ? allChannels
+                     : static_cast<std::uint8_t>(1u << (i % frames[i].size()));
+        std::size_t length = protocol::encodeFrame(
+            frame, type, static_cast<std::uint8_t>(i), mask, 0b101,
+            frames[i].data(), static_cast<std::uint32_t>(i * 10));
+        stream.append(reinterpret_cast<const char *>(frame), length);
+    }
+    return stream;
+}
+
+template <typename Parse>
+Result measure(std::uint64_t frameCount, Parse parse) {
+    Result result;
+    std::uint64_t allocationsBefore = allocations.load();
+    auto start = Clock::now();
+    while (result.frames < frameCount) {
+        result.frames += parse(result.checksum);
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start)
+                         .count();
+    result.allocations = allocations.load() - allocationsBefore;
+    return result;
+}
+
+// Read-only stream buffer over a line, standing in for the asio streambuf
+// the old line parsing read from
+class LineBuffer : public std::streambuf {
+public:
+    explicit LineBuffer(std::string_view line) {
+        char *begin = const_cast<char *>(line.data());
+        setg(begin, begin, begin + line.size());
+    }
+};
+
+// The line parsing SerialReader did before FrameParser
+int parseLineOld(std::string_view text) {
+    LineBuffer readBuffer(text);
+
+    // Read the line from the buffer
+    std::istream is(&readBuffer);
+    std::string line;
+    std::getline(is, line);
+
+    // Parse comma-separated values
+    std::vector<int> values;
+    std::string item;
+    std::istringstream iss(line);
+
+    while (std::getline(iss, item, ',')) {
+        try {
+            int value = std::stoi(item);
+            values.push_back(value);
+        } catch (const std::exception &) {
+            // Skip invalid values
+        }
+    }
+    return values.empty() ? 0 : values.front();
+}
+
+// Decode a whole stream once; returns the frames it held
+std::uint64_t decodeStream(FrameDecoder &decoder, std::string_view stream,
+                           std::uint64_t &checksum) {
+    std::uint64_t frames = 0;
+    while (!stream.empty()) {
+        FrameDecoder::Result result = decoder.decode(stream);
+        if (result.frameReady) {
+            const SerialFrame &frame = decoder.frame();
+            checksum += frame.values.front() + frame.changedChannels;
+            frames++;
+        }
+        if (result.consumed == 0) {
+            throw std::runtime_error("Truncated frame in the stream");
+        }
+        stream.remove_prefix(result.consumed);
+    }
+    return frames;
+}
+
+void printResult(const char *name, const Result &result) {
+    std::cout << name << result.seconds * 1e9 / result.frames
+              << " ns per frame, "
+              << static_cast<double>(result.allocations) / result.frames
+              << " allocations per frame\n";
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+int main(int argc, char **argv) {
+    try {
+        std::uint64_t frameCount = 1000000;
+        std::size_t channels = 5;
+        std::uint64_t seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.starts_with("--") && i + 1 < argc) {
+                std::string value = argv[++i];
+                if (arg == "--frames") {
+                    frameCount = std::stoull(value);
+                } else if (arg == "--channels") {
+                    channels = std::stoul(value);
+                } else if (arg == "--seed") {
+                    seed = std::stoull(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                std::cout << "Usage: VolWareParseBench [--frames N] "
+                             "[--channels N] [--seed N]\n";
+                return 1;
+            }
+        }
+        if (frameCount == 0 || channels == 0 ||
+            channels > protocol::MAX_CHANNELS) {
+            throw std::runtime_error(
+                "--frames must be positive and --channels 1 to " +
+                std::to_string(protocol::MAX_CHANNELS));
+        }
+
+        std::vector<std::vector<int>> values = makeValues(channels, seed);
+        std::string asciiStream = makeAsciiStream(values);
+        std::string binaryStream = makeBinaryStream(values);
+
+        // The parser sees lines without their newline, as the decoder
+        // passes them
+        std::vector<std::string_view> lines;
+        for (std::string_view rest = asciiStream; !rest.empty();) {
+            std::size_t newline = rest.find('\n');
+            lines.push_back(rest.substr(0, newline));
+            rest.remove_prefix(newline + 1);
+        }
+
+        Result oldResult =
+            measure(frameCount, [&](std::uint64_t &checksum) {
+                for (std::string_view line : lines) {
+                    checksum += parseLineOld(line);
+                }
+                return lines.size();
+            });
+
+        FrameParser parser;
+        Result parserResult =
+            measure(frameCount, [&](std::uint64_t &checksum) {
+                for (std::string_view line : lines) {
+                    checksum += parser.parse(line).front();
+                }
+                return lines.size();
+            });
+
+        FrameDecoder asciiDecoder;
+        Result asciiResult =
+            measure(frameCount, [&](std::uint64_t &checksum) {
+                return decodeStream(asciiDecoder, asciiStream, checksum);
+            });
+
+        FrameDecoder binaryDecoder;
+        Result binaryResult =
+            measure(frameCount, [&](std::uint64_t &checksum) {
+                return decodeStream(binaryDecoder, binaryStream, checksum);
+            });
+
+        std::cout << "Channels:        " << channels << "\n"
+                  << "Frames:          " << parserResult.frames
+                  << " per stage (ASCII " << asciiStream.size() / STREAM_FRAMES
+                  << " bytes, binary " << binaryStream.size() / STREAM_FRAMES
+                  << " bytes on average)\n";
+        printResult("Old line path:   ", oldResult);
+        printResult("FrameParser:     ", parserResult);
+        printResult("Decoder ASCII:   ", asciiResult);
+        printResult("Decoder binary:  ", binaryResult);
+        std::cout << "Checksum:        "
+                  << (oldResult.checksum + parserResult.checksum +
+                      asciiResult.checksum + binaryResult.checksum) %
+                         1000
+                  << std::endl;
+
+        bool allocationFree = parserResult.allocations == 0 &&
+                              asciiResult.allocations == 0 &&
+                              binaryResult.allocations == 0;
+        if (!allocationFree) {
+            std::cerr << "Error: the parse path allocated" << std::endl;
+        }
+        return allocationFree ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
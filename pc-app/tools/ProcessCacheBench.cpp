@@ -0,0 +1,198 @@
+/**
+ * ProcessCacheBench - Load test for ProcessNameCache
+ *
+ * The synthetic mode runs several threads against one cache with --pids
+ * processes, most lookups going to a fifth of them, and restarts processes
+ * under the same PID at the --reuse rate. Every name returned is checked
+ * against the process instance it was looked up for, so a stale name after
+ * PID reuse counts as an error:
+ *
+ *   VolWareProcessCacheBench --pids 2000 --capacity 256 --threads 4
+ *
+ * With --proc, every process in /proc is resolved through the cache for
+ * --rounds rounds instead, which shows the cost of a miss against a hit.
+ */
+
+#include "ProcessNameCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string syntheticName(std::uint32_t processId, std::uint64_t startTime) {
+    return "app" + std::to_string(processId) + "-" +
+           std::to_string(startTime) + ".exe";
+}
+
+void printStats(const ProcessNameCache &cache) {
+    ProcessNameCache::Stats stats = cache.getStats();
+    std::uint64_t lookups = stats.hits + stats.misses;
+    std::cout << "Hits:            " << stats.hits << " ("
+              << (lookups ? 100.0 * stats.hits / lookups : 0.0) << " %)\n"
+              << "Misses:          " << stats.misses << "\n"
+              << "Evictions:       " << stats.evictions << "\n"
+              << "Cached entries:  " << stats.size << "\n";
+}
+
+int runSynthetic(std::size_t capacity, std::uint32_t processCount,
+                 unsigned int threads, std::uint64_t lookups, double reuse,
+                 std::uint64_t seed) {
+    ProcessNameCache cache(capacity);
+
+    // Start time of the instance currently running under each PID
+    std::vector<std::atomic<std::uint64_t>> startTimes(processCount);
+    for (auto &startTime : startTimes) {
+        startTime.store(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint64_t> errors{0};
+    std::atomic<std::uint64_t> restarts{0};
+    auto worker = [&](unsigned int index) {
+        std::mt19937_64 random(seed + index);
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        std::uint32_t hotCount = std::max<std::uint32_t>(1, processCount / 5);
+        std::uniform_int_distribution<std::uint32_t> hotPid(0, hotCount - 1);
+        std::uniform_int_distribution<std::uint32_t> anyPid(0,
+                                                            processCount - 1);
+
+        std::string name;
+        for (std::uint64_t i = 0; i < lookups; i++) {
+            std::uint32_t processId =
+                chance(random) < 0.8 ? hotPid(random) : anyPid(random);
+            if (chance(random) < reuse) {
+                startTimes[processId].fetch_add(1, std::memory_order_relaxed);
+                restarts.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            std::uint64_t startTime =
+                startTimes[processId].load(std::memory_order_relaxed);
+            if (cache.find(processId, startTime, name)) {
+                if (name != syntheticName(processId, startTime)) {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            } else {
+                cache.insert(processId, startTime,
+                             syntheticName(processId, startTime));
+            }
+        }
+    };
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(worker, i);
+    }
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+    double elapsed = secondsSince(start);
+
+    std::uint64_t total = lookups * threads;
+    std::cout << "Processes:       " << processCount << " ("
+              << restarts.load() << " restarts)\n"
+              << "Capacity:        " << capacity << "\n"
+              << "Lookups:         " << total << " on " << threads
+              << " threads, " << total / elapsed / 1e6 << " M per second\n";
+    printStats(cache);
+    std::cout << "Wrong names:     " << errors.load() << std::endl;
+    return errors.load() == 0 ? 0 : 1;
+}
+
+int runProc(std::size_t capacity, unsigned int rounds) {
+    std::vector<ProcessNameCache::ProcessId> processIds;
+    for (const auto &entry : std::filesystem::directory_iterator("/proc")) {
+        const std::string name = entry.path().filename().string();
+        if (!name.empty() &&
+            name.find_first_not_of("0123456789") == std::string::npos) {
+            processIds.push_back(std::stoul(name));
+        }
+    }
+
+    ProcessNameCache cache(capacity);
+    for (unsigned int round = 0; round < rounds; round++) {
+        auto start = Clock::now();
+        for (ProcessNameCache::ProcessId processId : processIds) {
+            cache.resolve(processId);
+        }
+        double elapsed = secondsSince(start);
+        std::cout << "Round " << round + 1 << ":         "
+                  << elapsed * 1e6 / processIds.size()
+                  << " us per process\n";
+    }
+    std::cout << "Processes:       " << processIds.size() << "\n"
+              << "Capacity:        " << capacity << "\n";
+    printStats(cache);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        std::size_t capacity = ProcessNameCache::DEFAULT_CAPACITY;
+        std::uint32_t processCount = 2000;
+        unsigned int threads = 4;
+        std::uint64_t lookups = 1000000;
+        double reuse = 0.001;
+        std::uint64_t seed = 1;
+        unsigned int rounds = 3;
+        bool proc = false;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--proc") {
+                proc = true;
+            } else if (arg.starts_with("--") && i + 1 < argc) {
+                std::string value = argv[++i];
+                if (arg == "--capacity") {
+                    capacity = std::stoul(value);
+                } else if (arg == "--pids") {
+                    processCount = std::stoul(value);
+                } else if (arg == "--threads") {
+                    threads = std::stoul(value);
+                } else if (arg == "--lookups") {
+                    lookups = std::stoull(value);
+                } else if (arg == "--reuse") {
+                    reuse = std::stod(value);
+                } else if (arg == "--seed") {
+                    seed = std::stoull(value);
+                } else if (arg == "--rounds") {
+                    rounds = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                std::cout << "Usage: VolWareProcessCacheBench [--capacity N] "
+                             "[--pids N] [--threads N]\n"
+                             "       [--lookups N] [--reuse P] [--seed N] "
+                             "[--proc [--rounds N]]\n";
+                return 1;
+            }
+        }
+        if (processCount == 0 || threads == 0) {
+            throw std::runtime_error("--pids and --threads must be positive");
+        }
+
+        return proc ? runProc(capacity, rounds)
+                    : runSynthetic(capacity, processCount, threads, lookups,
+                                   reuse, seed);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,441 @@
+/**
+ * PulseSmokeTest - PulseAudioBackend against a running server
+ *
+ * Plays a silent stream on a sink, by default the null sink of the private
+ * daemon described in the README, and checks the backend end to end: the
+ * stream must show up as a session with its binary name, volume and mute
+ * writes must reach the server, the backend must not report those writes
+ * back as changes of another program, a change made through a second
+ * connection must be reported, and the session must go away with the
+ * stream. The default sink's volume is set as well and then restored:
+ *
+ *   export PULSE_SERVER=unix:/tmp/volware-pulse
+ *   VolWarePulseSmokeTest --sink volware_test
+ *
+ * Prints one line per check and fails if any check does.
+ */
+
+#include "PulseAudioBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Binary name the test stream claims, so it cannot be confused with others
+constexpr const char *STREAM_BINARY = "volware-smoke-test";
+
+// Volumes are compared at the resolution the server stores them with
+constexpr float LEVEL_TOLERANCE = 0.01f;
+
+int failures = 0;
+
+void report(bool passed, const std::string &check) {
+    std::cout << (passed ? "OK      " : "FAILED  ") << check << std::endl;
+    failures += !passed;
+}
+
+// Records the backend's notifications for the checks to wait on
+class Recorder : public AudioBackend::Listener {
+public:
+    struct Change {
+        AudioBackend::SessionId sessionId;
+        float volumeLevel;
+        bool mute;
+    };
+
+    void onSessionAdded(const AudioBackend::SessionInfo &session) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_added.push_back(session);
+        m_condition.notify_all();
+    }
+
+    void onSessionRemoved(AudioBackend::SessionId sessionId) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_removed.push_back(sessionId);
+        m_condition.notify_all();
+    }
+
+    void onSessionVolumeChanged(AudioBackend::SessionId sessionId,
+                                float volumeLevel, bool mute) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changes.push_back({sessionId, volumeLevel, mute});
+        m_condition.notify_all();
+    }
+
+    // Wait until predicate holds for the recorded notifications
+    template <typename Predicate>
+    bool waitFor(std::chrono::milliseconds timeout, Predicate predicate) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_condition.wait_for(lock, timeout, [&] {
+            return predicate(m_added, m_removed, m_changes);
+        });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<AudioBackend::SessionInfo> m_added;
+    std::vector<AudioBackend::SessionId> m_removed;
+    std::vector<Change> m_changes;
+};
+
+// Second connection that plays the test stream and acts as another
+// program changing its volume
+class Client {
+public:
+    Client() {
+        m_mainloop = pa_threaded_mainloop_new();
+        m_context = m_mainloop
+                        ? pa_context_new(
+                              pa_threaded_mainloop_get_api(m_mainloop),
+                              "VolWare smoke test client")
+                        : nullptr;
+        if (!m_context) {
+            throw std::runtime_error("Failed to create a PulseAudio client.");
+        }
+        pa_context_set_state_callback(m_context, signal, this);
+
+        pa_threaded_mainloop_lock(m_mainloop);
+        bool connected = pa_context_connect(m_context, nullptr,
+                                            PA_CONTEXT_NOFLAGS, nullptr) >=
+                             0 &&
+                         pa_threaded_mainloop_start(m_mainloop) >= 0;
+        while (connected &&
+               pa_context_get_state(m_context) != PA_CONTEXT_READY) {
+            connected = PA_CONTEXT_IS_GOOD(pa_context_get_state(m_context));
+            if (connected) {
+                pa_threaded_mainloop_wait(m_mainloop);
+            }
+        }
+        pa_threaded_mainloop_unlock(m_mainloop);
+        if (!connected) {
+            throw std::runtime_error("Failed to connect to PulseAudio server.");
+        }
+    }
+
+    ~Client() {
+        closeStream();
+        pa_threaded_mainloop_lock(m_mainloop);
+        pa_context_disconnect(m_context);
+        pa_context_unref(m_context);
+        pa_threaded_mainloop_unlock(m_mainloop);
+        pa_threaded_mainloop_stop(m_mainloop);
+        pa_threaded_mainloop_free(m_mainloop);
+    }
+
+    // Start playing silence on sink; returns the stream's sink-input index
+    uint32_t openStream(const std::string &sink) {
+        const pa_sample_spec spec = {PA_SAMPLE_S16LE, 44100, 2};
+        pa_proplist *properties = pa_proplist_new();
+        pa_proplist_sets(properties, PA_PROP_APPLICATION_PROCESS_BINARY,
+                         STREAM_BINARY);
+
+        pa_threaded_mainloop_lock(m_mainloop);
+        m_stream = pa_stream_new_with_proplist(m_context, "Silence", &spec,
+                                               nullptr, properties);
+        pa_proplist_free(properties);
+        uint32_t index = PA_INVALID_INDEX;
+        if (m_stream) {
+            pa_stream_set_state_callback(
+                m_stream, [](pa_stream *, void *userdata) {
+                    signal(nullptr, userdata);
+                },
+                this);
+            pa_stream_set_write_callback(m_stream, writeSilence, nullptr);
+            bool good = pa_stream_connect_playback(
+                            m_stream, sink.c_str(), nullptr,
+                            PA_STREAM_NOFLAGS, nullptr, nullptr) >= 0;
+            while (good && pa_stream_get_state(m_stream) != PA_STREAM_READY) {
+                good = PA_STREAM_IS_GOOD(pa_stream_get_state(m_stream));
+                if (good) {
+                    pa_threaded_mainloop_wait(m_mainloop);
+                }
+            }
+            if (good) {
+                index = pa_stream_get_index(m_stream);
+            }
+        }
+        pa_threaded_mainloop_unlock(m_mainloop);
+        return index;
+    }
+
+    void closeStream() {
+        pa_threaded_mainloop_lock(m_mainloop);
+        if (m_stream) {
+            pa_stream_set_state_callback(m_stream, nullptr, nullptr);
+            pa_stream_set_write_callback(m_stream, nullptr, nullptr);
+            pa_stream_disconnect(m_stream);
+            pa_stream_unref(m_stream);
+            m_stream = nullptr;
+        }
+        pa_threaded_mainloop_unlock(m_mainloop);
+    }
+
+    // Volume and mute of a sink-input as the server holds them
+    bool querySinkInput(uint32_t index, float &volumeLevel, bool &mute) {
+        State state;
+        bool done = run(state, [&] {
+            return pa_context_get_sink_input_info(
+                m_context, index,
+                [](pa_context *, const pa_sink_input_info *info, int eol,
+                   void *userdata) {
+                    auto *state = static_cast<State *>(userdata);
+                    if (!eol && info) {
+                        state->found = true;
+                        state->volume = info->volume;
+                        state->mute = info->mute != 0;
+                    }
+                    pa_threaded_mainloop_signal(state->mainloop, 0);
+                },
+                &state);
+        });
+        volumeLevel = levelOf(state.volume);
+        mute = state.mute;
+        return done && state.found;
+    }
+
+    bool queryDefaultSink(float &volumeLevel) {
+        State state;
+        bool done = run(state, [&] {
+            return pa_context_get_sink_info_by_name(
+                m_context, "@DEFAULT_SINK@",
+                [](pa_context *, const pa_sink_info *info, int eol,
+                   void *userdata) {
+                    auto *state = static_cast<State *>(userdata);
+                    if (!eol && info) {
+                        state->found = true;
+                        state->volume = info->volume;
+                    }
+                    pa_threaded_mainloop_signal(state->mainloop, 0);
+                },
+                &state);
+        });
+        volumeLevel = levelOf(state.volume);
+        return done && state.found;
+    }
+
+    // Change a sink-input's volume the way a mixer application would
+    bool setSinkInputVolume(uint32_t index, float volumeLevel) {
+        pa_cvolume volume;
+        pa_cvolume_set(&volume, 2,
+                       static_cast<pa_volume_t>(volumeLevel * PA_VOLUME_NORM));
+        State state;
+        return run(state, [&] {
+            return pa_context_set_sink_input_volume(
+                m_context, index, &volume,
+                [](pa_context *, int, void *userdata) {
+                    pa_threaded_mainloop_signal(
+                        static_cast<State *>(userdata)->mainloop, 0);
+                },
+                &state);
+        });
+    }
+
+private:
+    struct State {
+        pa_threaded_mainloop *mainloop = nullptr;
+        bool found = false;
+        pa_cvolume volume{};
+        bool mute = false;
+    };
+
+    static void signal(pa_context *, void *userdata) {
+        pa_threaded_mainloop_signal(
+            static_cast<Client *>(userdata)->m_mainloop, 0);
+    }
+
+    static void writeSilence(pa_stream *stream, size_t bytes, void *) {
+        static const std::vector<char> silence(64 * 1024, 0);
+        while (bytes > 0) {
+            size_t chunk = std::min(bytes, silence.size());
+            pa_stream_write(stream, silence.data(), chunk, nullptr, 0,
+                            PA_SEEK_RELATIVE);
+            bytes -= chunk;
+        }
+    }
+
+    static float levelOf(const pa_cvolume &volume) {
+        return volume.channels > 0 ? static_cast<float>(
+                                         pa_cvolume_max(&volume)) /
+                                         PA_VOLUME_NORM
+                                   : 0.0f;
+    }
+
+    // Start an operation whose callback signals the mainloop and wait for
+    // it, all with the mainloop lock held
+    template <typename Start> bool run(State &state, Start start) {
+        state.mainloop = m_mainloop;
+        pa_threaded_mainloop_lock(m_mainloop);
+        pa_operation *operation = start();
+        if (operation) {
+            while (pa_operation_get_state(operation) ==
+                   PA_OPERATION_RUNNING) {
+                pa_threaded_mainloop_wait(m_mainloop);
+            }
+            pa_operation_unref(operation);
+        }
+        pa_threaded_mainloop_unlock(m_mainloop);
+        return operation != nullptr;
+    }
+
+    pa_threaded_mainloop *m_mainloop = nullptr;
+    pa_context *m_context = nullptr;
+    pa_stream *m_stream = nullptr;
+};
+
+// Poll until the server holds the level; writes are not acknowledged
+template <typename Query>
+bool waitForLevel(Query query, float expected) {
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    do {
+        float level = -1.0f;
+        if (query(level) && std::abs(level - expected) < LEVEL_TOLERANCE) {
+            return true;
+        }
+        std::this_thread::sleep_for(20ms);
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        std::string sink = "volware_test";
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--sink" && i + 1 < argc) {
+                sink = argv[++i];
+            } else {
+                std::cout << "Usage: VolWarePulseSmokeTest [--sink NAME]\n";
+                return 1;
+            }
+        }
+
+        Client client;
+        Recorder recorder;
+        PulseAudioBackend backend;
+        report(backend.start(recorder), "backend started");
+
+        uint32_t index = client.openStream(sink);
+        if (index == PA_INVALID_INDEX) {
+            report(false, "stream opened on sink " + sink);
+            return 1;
+        }
+        report(recorder.waitFor(2s,
+                                [&](const auto &added, const auto &,
+                                    const auto &) {
+                                    for (const auto &session : added) {
+                                        if (session.id == index) {
+                                            return session.processName ==
+                                                   STREAM_BINARY;
+                                        }
+                                    }
+                                    return false;
+                                }),
+               "stream reported as session of " + std::string(STREAM_BINARY));
+
+        // Our own writes reach the server but are not reported back
+        backend.setSessionVolume(index, 0.25f);
+        report(waitForLevel(
+                   [&](float &level) {
+                       bool mute;
+                       return client.querySinkInput(index, level, mute);
+                   },
+                   0.25f),
+               "session volume set to 25%");
+
+        backend.setSessionMute(index, true);
+        bool muted = false;
+        auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (!muted && std::chrono::steady_clock::now() < deadline) {
+            float level;
+            client.querySinkInput(index, level, muted);
+            std::this_thread::sleep_for(20ms);
+        }
+        report(muted, "session muted");
+
+        bool echoed = recorder.waitFor(
+            300ms, [&](const auto &, const auto &, const auto &changes) {
+                for (const auto &change : changes) {
+                    if (change.sessionId == index) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+        report(!echoed, "own writes not reported as external changes");
+
+        // A change by another program is reported
+        client.setSinkInputVolume(index, 0.6f);
+        report(recorder.waitFor(
+                   2s, [&](const auto &, const auto &, const auto &changes) {
+                       for (const auto &change : changes) {
+                           if (change.sessionId == index &&
+                               std::abs(change.volumeLevel - 0.6f) <
+                                   LEVEL_TOLERANCE) {
+                               return true;
+                           }
+                       }
+                       return false;
+                   }),
+               "external volume change reported");
+
+        // The default sink, restored afterwards
+        float originalLevel = 0.0f;
+        if (client.queryDefaultSink(originalLevel)) {
+            float level = originalLevel > 0.45f && originalLevel < 0.55f
+                              ? 0.3f
+                              : 0.5f;
+            backend.setMasterVolume(level);
+            report(waitForLevel(
+                       [&](float &current) {
+                           return client.queryDefaultSink(current);
+                       },
+                       level),
+                   "default sink volume set");
+            backend.setMasterVolume(originalLevel);
+            waitForLevel(
+                [&](float &current) {
+                    return client.queryDefaultSink(current);
+                },
+                originalLevel);
+        } else {
+            report(false, "default sink found");
+        }
+
+        client.closeStream();
+        report(recorder.waitFor(2s,
+                                [&](const auto &, const auto &removed,
+                                    const auto &) {
+                                    for (auto sessionId : removed) {
+                                        if (sessionId == index) {
+                                            return true;
+                                        }
+                                    }
+                                    return false;
+                                }),
+               "session removed with the stream");
+
+        std::cout << (failures == 0
+                          ? "All checks passed"
+                          : "Failed checks: " + std::to_string(failures))
+                  << std::endl;
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,287 @@
+/**
+ * SerialBench - Reads several devices on one shared I/O context
+ *
+ * Benchmark for the serial input path with many devices. Start one
+ * VolWareDeviceSim per device, each with its own --link, then point this
+ * tool at the links:
+ *
+ *   VolWareDeviceSim --link /tmp/volware-tty0 --rate 0 &
+ *   VolWareDeviceSim --link /tmp/volware-tty1 --rate 0 &
+ *   VolWareSerialBench --duration 10 /tmp/volware-tty0 /tmp/volware-tty1
+ *
+ * Reports frames per second per device and the CPU time spent, with the
+ * number of I/O threads fixed by --threads regardless of the device count.
+ *
+ * With --apply, frames continue through the application's volume path: a
+ * VolumeApplier and a VolumeController writing to a SimulatedAudioBackend
+ * that takes --backend-us per call, with --sessions sessions behind each
+ * of the --channels knobs of a device. The latency tracer then reports
+ * every stage from receive to the backend calls returning, and the applier
+ * how many values it applied and coalesced.
+ */
+
+#include "DispatchTable.h"
+#include "LatencyTracer.h"
+#include "SerialIoContext.h"
+#include "SerialReader.h"
+#include "SimulatedAudioBackend.h"
+#include "VolumeApplier.h"
+#include "VolumeController.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+double cpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct DeviceCounters {
+    std::atomic<std::uint64_t> frames{0};
+    std::atomic<std::uint64_t> values{0};
+};
+
+// Volume path behind the readers for --apply: global channel c controls
+// the sessions of "app<c>.exe"
+class VolumePath {
+public:
+    VolumePath(int channelCount, unsigned int sessionsPerChannel,
+               std::chrono::microseconds backendLatency)
+        : m_applier([this](std::span<const VolumeApplier::Update> updates) {
+              apply(updates);
+          }) {
+        std::unordered_map<int, std::vector<std::string>> channelApps;
+        auto backend = std::make_unique<SimulatedAudioBackend>();
+        std::uint32_t processId = 1000;
+        for (int channel = 0; channel < channelCount; channel++) {
+            std::string app = "app" + std::to_string(channel) + ".exe";
+            channelApps[channel] = {app};
+            for (unsigned int i = 0; i < sessionsPerChannel; i++) {
+                backend->addSession(processId++, app);
+            }
+        }
+        m_dispatchTable = DispatchTable(channelApps);
+
+        // Sessions are taken in without latency
+        m_backend = backend.get();
+        m_controller =
+            std::make_unique<VolumeController>(std::move(backend));
+        m_controller->setTargets(m_dispatchTable.matcher());
+        m_controller->applyFrame({});
+        m_backend->setCallLatency(backendLatency);
+        m_backend->resetCallCounts();
+    }
+
+    void start() { m_applier.start(); }
+    void stop() { m_applier.stop(); }
+
+    // Reader callback: values first, then the mute states of a board with
+    // a button per knob
+    void post(const SerialFrame &frame, int channelOffset, int channels) {
+        m_applier.frameReceived();
+        std::size_t valueCount =
+            frame.valueCount != SerialFrame::UNKNOWN_VALUE_COUNT
+                ? static_cast<std::size_t>(frame.valueCount)
+                : frame.values.size() / 2;
+        for (int i = 0;
+             static_cast<std::size_t>(i) < valueCount && i < channels; i++) {
+            if (!(frame.changedChannels & (1u << i))) {
+                continue;
+            }
+            int mute = valueCount + i < frame.values.size()
+                           ? frame.values[valueCount + i]
+                           : VolumeApplier::NO_MUTE;
+            m_applier.post(channelOffset + i, frame.values[i], mute,
+                           frame.receivedUs);
+        }
+    }
+
+    VolumeApplier::Stats applierStats() const {
+        return m_applier.getStats();
+    }
+    SimulatedAudioBackend::CallCounts backendCalls() const {
+        return m_backend->getCallCounts();
+    }
+
+private:
+    void apply(std::span<const VolumeApplier::Update> updates) {
+        std::array<VolumeController::ChannelUpdate,
+                   VolumeApplier::MAX_CHANNELS>
+            frame;
+        std::size_t count = 0;
+        for (const VolumeApplier::Update &update : updates) {
+            const DispatchTable::Channel &channel =
+                m_dispatchTable.channel(update.channel);
+            frame[count++] = {m_dispatchTable.targets(channel), false,
+                              update.value / 1023.0f, update.mute};
+        }
+        m_controller->applyFrame(std::span(frame.data(), count));
+    }
+
+    DispatchTable m_dispatchTable;
+    SimulatedAudioBackend *m_backend = nullptr; // Owned by the controller
+    std::unique_ptr<VolumeController> m_controller;
+    VolumeApplier m_applier;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        double duration = 10.0;
+        unsigned int threads = 1;
+        unsigned int baudRate = 115200;
+        bool binary = false;
+        bool apply = false;
+        int channels = 5;
+        unsigned int sessions = 1;
+        unsigned int backendUs = 0;
+        std::vector<std::string> ports;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--binary") {
+                binary = true;
+            } else if (arg == "--apply") {
+                apply = true;
+            } else if (arg.starts_with("--") && i + 1 < argc) {
+                std::string value = argv[++i];
+                if (arg == "--duration") {
+                    duration = std::stod(value);
+                } else if (arg == "--threads") {
+                    threads = std::stoul(value);
+                } else if (arg == "--baud") {
+                    baudRate = std::stoul(value);
+                } else if (arg == "--channels") {
+                    channels = std::stoi(value);
+                } else if (arg == "--sessions") {
+                    sessions = std::stoul(value);
+                } else if (arg == "--backend-us") {
+                    backendUs = std::stoul(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                ports.push_back(arg);
+            }
+        }
+        if (ports.empty()) {
+            std::cout << "Usage: VolWareSerialBench [--duration SEC] "
+                         "[--threads N] [--baud N] [--binary]\n"
+                         "       [--apply [--channels N] [--sessions N] "
+                         "[--backend-us N]] PORT...\n";
+            return 1;
+        }
+        int channelCount = channels * static_cast<int>(ports.size());
+        if (apply &&
+            (channels < 1 || channelCount > VolumeApplier::MAX_CHANNELS)) {
+            throw std::runtime_error(
+                "--apply supports up to " +
+                std::to_string(VolumeApplier::MAX_CHANNELS) +
+                " channels over all ports");
+        }
+
+        std::unique_ptr<VolumePath> volumePath;
+        if (apply) {
+            volumePath = std::make_unique<VolumePath>(
+                channelCount, sessions,
+                std::chrono::microseconds(backendUs));
+
+            // Frames are only stamped with their receive time while tracing
+            LatencyTracer::global().enable(0, "");
+            volumePath->start();
+        }
+
+        SerialIoContext serialIo(threads);
+        serialIo.start();
+
+        std::vector<DeviceCounters> counters(ports.size());
+        std::vector<std::unique_ptr<SerialReader>> readers;
+        for (std::size_t i = 0; i < ports.size(); i++) {
+            auto reader = std::make_unique<SerialReader>(serialIo.context(),
+                                                         ports[i], baudRate);
+            DeviceCounters &counter = counters[i];
+            int channelOffset = static_cast<int>(i) * channels;
+            reader->setCallback([&counter, &volumePath, channelOffset,
+                                 channels](const SerialFrame &frame) {
+                counter.frames.fetch_add(1, std::memory_order_relaxed);
+                counter.values.fetch_add(frame.values.size(),
+                                         std::memory_order_relaxed);
+                if (volumePath) {
+                    volumePath->post(frame, channelOffset, channels);
+                }
+            });
+            reader->setSyncMessage("s");
+            if (binary) {
+                reader->setProtocol(SerialProtocol::Binary);
+            }
+            reader->start();
+            readers.push_back(std::move(reader));
+        }
+
+        double cpuStart = cpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+        double elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        double cpu = cpuSeconds() - cpuStart;
+
+        for (auto &reader : readers) {
+            reader->stop();
+        }
+        serialIo.stop();
+        if (volumePath) {
+            volumePath->stop();
+        }
+
+        std::uint64_t totalFrames = 0;
+        for (std::size_t i = 0; i < ports.size(); i++) {
+            std::uint64_t frames = counters[i].frames;
+            totalFrames += frames;
+            std::cout << ports[i] << ": " << frames << " frames, "
+                      << frames / elapsed << " per second\n";
+        }
+        std::cout << "Total: " << totalFrames / elapsed << " frames per second"
+                  << " on " << threads << " I/O thread(s), CPU "
+                  << cpu / elapsed * 100.0 << "% ("
+                  << (totalFrames ? cpu / totalFrames * 1e6 : 0.0)
+                  << " us per frame)" << std::endl;
+
+        if (volumePath) {
+            VolumeApplier::Stats stats = volumePath->applierStats();
+            std::uint64_t calls = volumePath->backendCalls().total();
+            std::cout << "Applied: " << stats.updatesApplied / elapsed
+                      << " values per second, " << stats.updatesCoalesced
+                      << " of " << stats.updatesPosted
+                      << " coalesced, receive to applied "
+                      << (stats.updatesApplied
+                              ? stats.applyLatencyTotalUs /
+                                    stats.updatesApplied
+                              : 0)
+                      << " us mean, " << stats.applyLatencyMaxUs
+                      << " us max\n"
+                      << "Backend: " << calls / elapsed
+                      << " calls per second\n";
+            LatencyTracer::global().writeSummary(std::cout);
+            LatencyTracer::global().stop();
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,415 @@
+/**
+ * SessionBench - Session index check and lookup benchmark
+ *
+ * Checks the session index first, then measures it. The check compares
+ * SessionIndex against a plain list under random adds, removes and
+ * renames, and drives VolumeController through a SimulatedAudioBackend,
+ * which stands in for the platform's session notifications. It applies
+ * frames through a DispatchTable with exact names, globs, exclusions,
+ * "unmapped" and "master". Every session must end up at the volume of the
+ * channel it belongs to, including sessions that appear after the first
+ * frame, while removed sessions are no longer written. The controller's
+ * own writes must not count as changes made by other programs, while a
+ * change the backend reports must.
+ *
+ * The benchmark then loads 10 to 500 sessions (--sessions) and reports,
+ * per count, a SessionIndex lookup next to a scan of every session as the
+ * platform enumerators do, and a full applyFrame() against the simulated
+ * backend:
+ *
+ *   VolWareSessionBench --sessions 10,50,100,250,500
+ *
+ * The tool fails if the check does.
+ */
+
+#include "AppMatcher.h"
+#include "DispatchTable.h"
+#include "SessionIndex.h"
+#include "SimulatedAudioBackend.h"
+#include "VolumeController.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using SessionId = AudioBackend::SessionId;
+
+// Channel layout of the check, and the channel each process belongs to
+const std::unordered_map<int, std::vector<std::string>> CHECK_CHANNELS = {
+    {0, {"master"}},
+    {1, {"Spotify.exe", "chrome*"}},
+    {2, {"*.exe", "!explorer.exe"}},
+    {3, {"unmapped", "!systemd*"}},
+};
+
+constexpr int NO_CHANNEL = -1;
+
+struct CheckProcess {
+    const char *name;
+    int channel;
+};
+
+const CheckProcess CHECK_PROCESSES[] = {
+    {"spotify.exe", 1},
+    {"SPOTIFY.EXE", 1},
+    {"chrome", 1},
+    {"chrome_crashpad", 1},
+    {"game.exe", 2},
+    {"explorer.exe", 3}, // Excluded from "*.exe"
+    {"firefox", 3},
+    {"systemd-logind", NO_CHANNEL}, // Excluded from "unmapped"
+};
+
+int failures = 0;
+
+void expect(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// SessionIndex against a list that is searched in full every time
+void checkIndex(std::uint64_t seed) {
+    struct Reference {
+        SessionId id;
+        std::string nameLower;
+    };
+
+    const std::vector<std::string> names = {"Spotify.exe", "spotify.exe",
+                                            "Discord.exe", "game.exe",
+                                            "GAME.EXE",    "firefox"};
+    std::mt19937_64 rng(seed);
+    SessionIndex<int> index;
+    std::vector<Reference> reference;
+
+    for (int step = 0; step < 20000; step++) {
+        SessionId id = rng() % 64;
+        const std::string &name = names[rng() % names.size()];
+        if (rng() % 3 != 0) {
+            // Adding a known ID renames the session
+            index.add(id, name, static_cast<int>(id));
+            std::erase_if(reference,
+                          [id](const Reference &r) { return r.id == id; });
+            reference.push_back({id, SessionIndex<int>::toLower(name)});
+        } else {
+            bool removed = index.remove(id);
+            bool known = std::erase_if(reference, [id](const Reference &r) {
+                             return r.id == id;
+                         }) > 0;
+            expect(removed == known, "remove() result of session " +
+                                         std::to_string(id));
+        }
+
+        for (const std::string &lookup : names) {
+            std::string lower = SessionIndex<int>::toLower(lookup);
+            std::vector<SessionId> expected;
+            for (const Reference &r : reference) {
+                if (r.nameLower == lower) {
+                    expected.push_back(r.id);
+                }
+            }
+            std::vector<SessionId> found;
+            for (const auto &entry : index.find(lower)) {
+                expect(entry.handle == static_cast<int>(entry.id),
+                       "handle of session " + std::to_string(entry.id));
+                found.push_back(entry.id);
+            }
+            std::sort(expected.begin(), expected.end());
+            std::sort(found.begin(), found.end());
+            if (found != expected) {
+                expect(false, "sessions of " + lower + " after step " +
+                                  std::to_string(step));
+                return;
+            }
+        }
+        expect(index.size() == reference.size(), "index size");
+    }
+}
+
+// Frame with channel i at levels[i]
+std::vector<VolumeController::ChannelUpdate>
+makeFrame(const DispatchTable &table, const std::vector<float> &levels) {
+    std::vector<VolumeController::ChannelUpdate> frame;
+    for (int channel = 0; channel < table.channelCount(); channel++) {
+        const DispatchTable::Channel &mapping = table.channel(channel);
+        frame.push_back({table.targets(mapping), mapping.master,
+                         levels[channel]});
+    }
+    return frame;
+}
+
+// Every listed session at the level of its channel, the others untouched
+void expectLevels(const SimulatedAudioBackend &backend,
+                  const std::vector<std::pair<SessionId, int>> &sessions,
+                  const std::vector<float> &levels, const std::string &when) {
+    for (const auto &[sessionId, channel] : sessions) {
+        std::optional<SimulatedAudioBackend::SessionState> state =
+            backend.getSession(sessionId);
+        if (!state) {
+            continue;
+        }
+        float expected = channel == NO_CHANNEL ? 1.0f : levels[channel];
+        expect(std::abs(state->volume - expected) < 1e-6f,
+               state->processName + " " + when + ": volume " +
+                   std::to_string(state->volume) + ", expected " +
+                   std::to_string(expected));
+    }
+    expect(std::abs(backend.getMasterVolume() - levels[0]) < 1e-6f,
+           "master volume " + when);
+}
+
+// VolumeController fed by the simulated backend's session notifications
+void checkController() {
+    DispatchTable table(CHECK_CHANNELS);
+    auto ownedBackend = std::make_unique<SimulatedAudioBackend>();
+    SimulatedAudioBackend &backend = *ownedBackend;
+
+    // Sessions that exist before the controller starts
+    std::vector<std::pair<SessionId, int>> sessions;
+    std::uint32_t processId = 100;
+    for (const CheckProcess &process : CHECK_PROCESSES) {
+        sessions.emplace_back(backend.addSession(processId++, process.name),
+                              process.channel);
+    }
+
+    VolumeController controller(std::move(ownedBackend));
+    controller.setTargets(table.matcher());
+
+    std::vector<float> levels = {0.1f, 0.2f, 0.3f, 0.4f};
+    std::vector<VolumeController::ChannelUpdate> frame =
+        makeFrame(table, levels);
+    controller.applyFrame(frame);
+    expectLevels(backend, sessions, levels, "after the first frame");
+
+    // Sessions that appear later get their channel's level with the next
+    // frame, empty or not
+    sessions.emplace_back(backend.addSession(processId++, "Chrome"), 1);
+    sessions.emplace_back(backend.addSession(processId++, "other.exe"), 2);
+    sessions.emplace_back(backend.addSession(processId++, "vlc"), 3);
+    controller.applyFrame({});
+    expectLevels(backend, sessions, levels, "after sessions appeared");
+
+    // A removed session is no longer written; its ID is not reused
+    SessionId removed = sessions.front().first;
+    backend.removeSession(removed);
+    sessions.erase(sessions.begin());
+    backend.resetCallCounts();
+    levels = {0.5f, 0.6f, 0.7f, 0.8f};
+    frame = makeFrame(table, levels);
+    controller.applyFrame(frame);
+    expectLevels(backend, sessions, levels, "after a session was removed");
+
+    std::uint64_t expectedWrites = 1; // Master
+    for (const auto &[sessionId, channel] : sessions) {
+        expectedWrites += channel != NO_CHANNEL;
+    }
+    expect(backend.getCallCounts().total() == expectedWrites,
+           "backend calls for the frame: " +
+               std::to_string(backend.getCallCounts().total()) +
+               ", expected " + std::to_string(expectedWrites));
+
+    // A repeated frame is absorbed by the value cache
+    backend.resetCallCounts();
+    controller.applyFrame(frame);
+    expect(backend.getCallCounts().total() == 0,
+           "backend calls for a repeated frame");
+
+    // Only a change of another program is reported as one
+    std::vector<VolumeController::ExternalChange> changes;
+    controller.setExternalChangeCallbacks(
+        [&changes](const VolumeController::ExternalChange &change) {
+            changes.push_back(change);
+        },
+        {});
+    expect(controller.getStats().externalChanges == 0,
+           "own writes counted as external changes");
+    const auto &[changedSession, changedChannel] = sessions.back();
+    backend.changeSessionVolume(changedSession, 0.9f, false);
+    controller.applyFrame({});
+    expect(changes.size() == 1 && !changes.front().master &&
+               std::abs(changes.front().volumeLevel - 0.9f) < 1e-6f,
+           "external change of channel " + std::to_string(changedChannel) +
+               " not reported");
+    controller.setExternalChangeCallbacks({}, {});
+}
+
+struct BenchResult {
+    double indexNs = 0;
+    double scanNs = 0;
+    double frameUs = 0;
+    std::uint64_t writesPerFrame = 0;
+};
+
+BenchResult runBench(std::size_t sessionCount, std::uint64_t lookups,
+                     std::uint64_t seed) {
+    // Every mapped application has a session; the rest are other
+    // applications, some with several sessions
+    const std::vector<std::string> mapped = {"Spotify.exe", "chrome.exe",
+                                             "Discord.exe", "game.exe"};
+    std::vector<std::string> names(mapped);
+    for (std::size_t i = names.size(); i < sessionCount; i++) {
+        names.push_back("App" + std::to_string(i / 2) + ".exe");
+    }
+    names.resize(sessionCount);
+
+    BenchResult result;
+    std::mt19937_64 rng(seed);
+    std::uint64_t checksum = 0;
+
+    // Index lookup of a mapped name against a scan that lowercases and
+    // compares the name of every session
+    SessionIndex<std::size_t> index;
+    for (std::size_t i = 0; i < names.size(); i++) {
+        index.add(i, names[i], i);
+    }
+    std::vector<std::string> lookupNames;
+    for (const std::string &name : mapped) {
+        lookupNames.push_back(SessionIndex<std::size_t>::toLower(name));
+    }
+
+    auto start = Clock::now();
+    for (std::uint64_t i = 0; i < lookups; i++) {
+        checksum += index.find(lookupNames[i % lookupNames.size()]).size();
+    }
+    result.indexNs = secondsSince(start) * 1e9 / lookups;
+
+    std::uint64_t scanLookups = std::max<std::uint64_t>(lookups / 100, 1);
+    start = Clock::now();
+    for (std::uint64_t i = 0; i < scanLookups; i++) {
+        const std::string &wanted = lookupNames[i % lookupNames.size()];
+        for (const std::string &name : names) {
+            checksum += SessionIndex<std::size_t>::toLower(name) == wanted;
+        }
+    }
+    result.scanNs = secondsSince(start) * 1e9 / scanLookups;
+
+    // Whole frames through the controller; every frame moves every knob
+    std::unordered_map<int, std::vector<std::string>> channelApps;
+    for (std::size_t i = 0; i < mapped.size(); i++) {
+        channelApps[static_cast<int>(i)] = {mapped[i]};
+    }
+    channelApps[0].push_back("master");
+    DispatchTable table(channelApps);
+
+    auto ownedBackend = std::make_unique<SimulatedAudioBackend>();
+    SimulatedAudioBackend &backend = *ownedBackend;
+    for (std::size_t i = 0; i < names.size(); i++) {
+        backend.addSession(static_cast<std::uint32_t>(1000 + i), names[i]);
+    }
+    VolumeController controller(std::move(ownedBackend));
+    controller.setTargets(table.matcher());
+
+    std::uniform_real_distribution<float> level(0.0f, 1.0f);
+    std::uint64_t frames = std::max<std::uint64_t>(lookups / 100, 1);
+    std::vector<std::vector<float>> levels(64);
+    for (std::vector<float> &frameLevels : levels) {
+        for (std::size_t i = 0; i < mapped.size(); i++) {
+            frameLevels.push_back(level(rng));
+        }
+    }
+    controller.applyFrame({}); // Take in the sessions
+    backend.resetCallCounts();
+
+    start = Clock::now();
+    for (std::uint64_t i = 0; i < frames; i++) {
+        std::vector<VolumeController::ChannelUpdate> frame =
+            makeFrame(table, levels[i % levels.size()]);
+        controller.applyFrame(frame);
+    }
+    result.frameUs = secondsSince(start) * 1e6 / frames;
+    result.writesPerFrame = backend.getCallCounts().total() / frames;
+
+    if (checksum == 0) {
+        throw std::runtime_error("No session was found");
+    }
+    return result;
+}
+
+std::vector<std::size_t> parseCounts(const std::string &list) {
+    std::vector<std::size_t> counts;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        counts.push_back(std::stoul(item));
+    }
+    return counts;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        std::vector<std::size_t> sessionCounts = {10, 50, 100, 250, 500};
+        std::uint64_t lookups = 1000000;
+        std::uint64_t seed = 1;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.starts_with("--") && i + 1 < argc) {
+                std::string value = argv[++i];
+                if (arg == "--sessions") {
+                    sessionCounts = parseCounts(value);
+                } else if (arg == "--lookups") {
+                    lookups = std::stoull(value);
+                } else if (arg == "--seed") {
+                    seed = std::stoull(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                std::cout << "Usage: VolWareSessionBench [--sessions N,N,...] "
+                             "[--lookups N] [--seed N]\n";
+                return 1;
+            }
+        }
+        if (lookups == 0) {
+            throw std::runtime_error("--lookups must be positive");
+        }
+
+        checkIndex(seed);
+        checkController();
+        if (failures > 0) {
+            std::cerr << "Check failed: " << failures << " errors"
+                      << std::endl;
+            return 1;
+        }
+        std::cout << "Check:           passed\n\n"
+                  << " Sessions  Index lookup    Full scan  Frame apply"
+                     "  Writes/frame\n";
+
+        for (std::size_t count : sessionCounts) {
+            BenchResult result = runBench(std::max<std::size_t>(count, 4),
+                                          lookups, seed);
+            std::cout << std::fixed << std::setprecision(1) << std::setw(9)
+                      << count << std::setw(11) << result.indexNs << " ns"
+                      << std::setw(10) << result.scanNs << " ns"
+                      << std::setw(10) << result.frameUs << " us"
+                      << std::setw(14) << result.writesPerFrame << "\n";
+        }
+        std::cout << std::flush;
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
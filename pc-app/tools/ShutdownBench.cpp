@@ -0,0 +1,169 @@
+/**
+ * ShutdownBench - Checks that an idle VolWare sleeps and exits promptly
+ *
+ * Starts the given command, lets it settle, then counts the context
+ * switches of each of its threads over an idle period from
+ * /proc/<pid>/task; a thread that does not wake up has none. Finally it
+ * sends SIGTERM and measures how long the process takes to exit:
+ *
+ *   VolWareDeviceSim --link /tmp/volware-tty --trace idle.txt &
+ *   VolWareShutdownBench --idle 5 -- ./VolWare --config config.yaml
+ *
+ * Exits with 1 if the main thread woke up while idle or the shutdown took
+ * longer than --limit-ms, so it can gate a build. Other threads are
+ * reported too; with --strict their wakeups fail the run as well.
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ThreadInfo {
+    std::string name;
+    std::uint64_t switches; // Voluntary and involuntary
+};
+
+// Context switches of every thread of a process, by thread ID
+std::map<pid_t, ThreadInfo> readThreads(pid_t pid) {
+    std::map<pid_t, ThreadInfo> threads;
+    std::filesystem::path taskDir =
+        "/proc/" + std::to_string(pid) + "/task";
+    std::error_code error;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(taskDir, error)) {
+        ThreadInfo info{"?", 0};
+        std::ifstream status(entry.path() / "status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.starts_with("Name:")) {
+                info.name = line.substr(line.find_first_not_of(" \t", 5));
+            } else if (line.starts_with("voluntary_ctxt_switches:") ||
+                       line.starts_with("nonvoluntary_ctxt_switches:")) {
+                info.switches += std::stoull(line.substr(line.find(':') + 1));
+            }
+        }
+        threads[std::stoi(entry.path().filename().string())] = info;
+    }
+    return threads;
+}
+
+void printUsage() {
+    std::cout << "Usage: VolWareShutdownBench [options] -- COMMAND [ARGS]\n"
+                 "  --settle SEC     Time to start up before measuring (2)\n"
+                 "  --idle SEC       Idle period to count wakeups over (5)\n"
+                 "  --limit-ms MS    Longest acceptable shutdown (50)\n"
+                 "  --strict         Fail on wakeups of any thread\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        double settle = 2.0;
+        double idle = 5.0;
+        double limitMs = 50.0;
+        bool strict = false;
+        std::vector<char *> command;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--") {
+                command.assign(argv + i + 1, argv + argc);
+                break;
+            } else if (arg == "--strict") {
+                strict = true;
+            } else if (arg.starts_with("--") && i + 1 < argc &&
+                       arg != "--help") {
+                std::string value = argv[++i];
+                if (arg == "--settle") {
+                    settle = std::stod(value);
+                } else if (arg == "--idle") {
+                    idle = std::stod(value);
+                } else if (arg == "--limit-ms") {
+                    limitMs = std::stod(value);
+                } else {
+                    throw std::runtime_error("Unknown option " + arg);
+                }
+            } else {
+                printUsage();
+                return arg == "--help" || arg == "-h" ? 0 : 1;
+            }
+        }
+        if (command.empty()) {
+            printUsage();
+            return 1;
+        }
+        command.push_back(nullptr);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+        if (pid == 0) {
+            execvp(command[0], command.data());
+            std::cerr << "Cannot run " << command[0] << std::endl;
+            _exit(127);
+        }
+
+        // Count wakeups over the idle period
+        std::this_thread::sleep_for(std::chrono::duration<double>(settle));
+        if (waitpid(pid, nullptr, WNOHANG) == pid) {
+            throw std::runtime_error("The command exited during start-up.");
+        }
+        std::map<pid_t, ThreadInfo> before = readThreads(pid);
+        std::this_thread::sleep_for(std::chrono::duration<double>(idle));
+        std::map<pid_t, ThreadInfo> after = readThreads(pid);
+
+        std::uint64_t mainWakeups = 0;
+        std::uint64_t totalWakeups = 0;
+        std::cout << "Wakeups over " << idle << " s idle:\n";
+        for (const auto &[tid, info] : after) {
+            auto previous = before.find(tid);
+            std::uint64_t wakeups =
+                info.switches -
+                (previous != before.end() ? previous->second.switches : 0);
+            std::cout << "  " << tid << " " << info.name
+                      << (tid == pid ? " (main)" : "") << ": " << wakeups
+                      << "\n";
+            totalWakeups += wakeups;
+            if (tid == pid) {
+                mainWakeups = wakeups;
+            }
+        }
+
+        // Time from the signal until the process has exited
+        Clock::time_point stopStart = Clock::now();
+        kill(pid, SIGTERM);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        double shutdownMs = std::chrono::duration<double, std::milli>(
+                                Clock::now() - stopStart)
+                                .count();
+
+        std::cout << "Shutdown: " << shutdownMs << " ms, exit status "
+                  << (WIFEXITED(status) ? WEXITSTATUS(status) : -1)
+                  << std::endl;
+
+        bool passed = mainWakeups == 0 && shutdownMs <= limitMs &&
+                      WIFEXITED(status) && (!strict || totalWakeups == 0);
+        std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+        return passed ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}